@@ -0,0 +1,5 @@
+cd bench && \
+mkdir -p build && cd build && \
+cmake .. && \
+cmake --build . && \
+./bench "$@" | tee ../../bench_output.txt
\ No newline at end of file
@@ -0,0 +1,337 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <sqlmate.hpp>
+
+using namespace sqlmate;
+
+/**
+ * Benchmarks of the ORM hot paths.
+ *
+ * Every benchmark runs on a fresh database, for each storage (in-memory, on-disk) and PRAGMA
+ * profile, and is repeated to report the best and median time per operation. Results are
+ * printed as one JSON object per line, tagged with the benchmarked commit, so that runs of
+ * different commits can be diffed or loaded by a script.
+ *
+ * Usage: bench [--rows N] [--repeat R] [--filter SUBSTRING] [--dir PATH]
+ */
+
+class Small : public AModel
+{
+public:
+    TABLE_NAME("BenchSmall")
+    Small(std::shared_ptr<IDatabase> db) : AModel(db)
+    {
+        FIELDS(FIELD(name),
+               FIELD(age),
+               FIELD(score))
+    }
+
+    std::string name;
+    int age = 0;
+    double score = 0;
+};
+
+class Wide : public AModel
+{
+public:
+    TABLE_NAME("BenchWide")
+    Wide(std::shared_ptr<IDatabase> db) : AModel(db)
+    {
+        FIELDS(FIELD(i0), FIELD(i1), FIELD(i2), FIELD(i3), FIELD(i4), FIELD(i5), FIELD(i6), FIELD(i7),
+               FIELD(d0), FIELD(d1), FIELD(d2), FIELD(d3), FIELD(d4), FIELD(d5), FIELD(d6), FIELD(d7),
+               FIELD(s0), FIELD(s1), FIELD(s2), FIELD(s3), FIELD(s4), FIELD(s5), FIELD(s6), FIELD(s7),
+               FIELD(l0), FIELD(l1), FIELD(l2), FIELD(l3), FIELD(l4), FIELD(l5), FIELD(l6), FIELD(l7))
+    }
+
+    int i0 = 0, i1 = 1, i2 = 2, i3 = 3, i4 = 4, i5 = 5, i6 = 6, i7 = 7;
+    double d0 = 0, d1 = 1, d2 = 2, d3 = 3, d4 = 4, d5 = 5, d6 = 6, d7 = 7;
+    std::string s0 = "s0", s1 = "s1", s2 = "s2", s3 = "s3", s4 = "s4", s5 = "s5", s6 = "s6", s7 = "s7";
+    int64_t l0 = 0, l1 = 1, l2 = 2, l3 = 3, l4 = 4, l5 = 5, l6 = 6, l7 = 7;
+};
+
+class StaticWide : public AModel
+{
+public:
+    StaticWide(std::shared_ptr<IDatabase> db) : AModel(db) {}
+
+    int i0 = 0, i1 = 1, i2 = 2, i3 = 3, i4 = 4, i5 = 5, i6 = 6, i7 = 7;
+    double d0 = 0, d1 = 1, d2 = 2, d3 = 3, d4 = 4, d5 = 5, d6 = 6, d7 = 7;
+    std::string s0 = "s0", s1 = "s1", s2 = "s2", s3 = "s3", s4 = "s4", s5 = "s5", s6 = "s6", s7 = "s7";
+    int64_t l0 = 0, l1 = 1, l2 = 2, l3 = 3, l4 = 4, l5 = 5, l6 = 6, l7 = 7;
+
+    SCHEMA(StaticWide, "BenchStaticWide",
+           COLUMN(i0), COLUMN(i1), COLUMN(i2), COLUMN(i3), COLUMN(i4), COLUMN(i5), COLUMN(i6), COLUMN(i7),
+           COLUMN(d0), COLUMN(d1), COLUMN(d2), COLUMN(d3), COLUMN(d4), COLUMN(d5), COLUMN(d6), COLUMN(d7),
+           COLUMN(s0), COLUMN(s1), COLUMN(s2), COLUMN(s3), COLUMN(s4), COLUMN(s5), COLUMN(s6), COLUMN(s7),
+           COLUMN(l0), COLUMN(l1), COLUMN(l2), COLUMN(l3), COLUMN(l4), COLUMN(l5), COLUMN(l6), COLUMN(l7))
+};
+
+struct Options
+{
+    int rows = 10000;
+    int repeat = 5;
+    std::string filter;
+    std::string dir = ".";
+};
+
+struct Storage
+{
+    std::string name;
+    std::string url;
+    std::string pragmas;
+};
+
+struct Context
+{
+    std::shared_ptr<IDatabase> db;
+    int rows;
+    std::vector<int> ids; ///< Ids of the rows inserted by the setup, if any.
+};
+
+struct Benchmark
+{
+    std::string name;
+    bool populate;                        ///< Whether the table is filled with `rows` rows before timing.
+    std::function<long(Context &)> run;   ///< Runs the timed section and returns the number of operations.
+};
+
+static void populate(Context &ctx)
+{
+    ctx.db->exec("BEGIN", nullptr);
+    for (int i = 0; i < ctx.rows; i++)
+    {
+        Small model(ctx.db);
+        model.name = "user" + std::to_string(i);
+        model.age = i % 100;
+        model.score = i * 0.5;
+        model.save();
+        ctx.ids.push_back(model.getId());
+    }
+    ctx.db->exec("COMMIT", nullptr);
+}
+
+static std::vector<Benchmark> benchmarks()
+{
+    return {
+        {"save_single", false, [](Context &ctx) -> long
+         {
+             int count = std::min(ctx.rows, 2000); // one implicit transaction per save
+             for (int i = 0; i < count; i++)
+             {
+                 Small model(ctx.db);
+                 model.name = "user";
+                 model.age = i;
+                 model.save();
+             }
+             return count;
+         }},
+        {"save_update", true, [](Context &ctx) -> long
+         {
+             Small probe(ctx.db);
+             auto models = probe.findAll<Small>();
+             ctx.db->exec("BEGIN", nullptr);
+             for (auto &model : models)
+             {
+                 model->age++;
+                 model->save();
+             }
+             ctx.db->exec("COMMIT", nullptr);
+             return static_cast<long>(models.size());
+         }},
+        {"bulk_insert", false, [](Context &ctx) -> long
+         {
+             populate(ctx);
+             return ctx.rows;
+         }},
+        {"find_one", true, [](Context &ctx) -> long
+         {
+             std::mt19937 rng(42);
+             std::uniform_int_distribution<std::size_t> pick(0, ctx.ids.size() - 1);
+             Small probe(ctx.db);
+             long found = 0;
+             for (int i = 0; i < ctx.rows; i++)
+                 found += probe.findOne<Small>(ctx.ids[pick(rng)]) ? 1 : 0;
+             if (found != ctx.rows)
+                 throw std::runtime_error("find_one missed rows");
+             return ctx.rows;
+         }},
+        {"find_all", true, [](Context &ctx) -> long
+         {
+             Small probe(ctx.db);
+             return static_cast<long>(probe.findAll<Small>().size());
+         }},
+        {"find_where", true, [](Context &ctx) -> long
+         {
+             Small probe(ctx.db);
+             long rows = 0;
+             for (int age = 0; age < 100; age++)
+                 rows += static_cast<long>(probe.findWhere<Small>("age = " + std::to_string(age)).size());
+             return rows;
+         }},
+        {"remove", true, [](Context &ctx) -> long
+         {
+             Small probe(ctx.db);
+             auto models = probe.findAll<Small>();
+             ctx.db->exec("BEGIN", nullptr);
+             for (auto &model : models)
+                 model->remove();
+             ctx.db->exec("COMMIT", nullptr);
+             return static_cast<long>(models.size());
+         }},
+        {"wide_save", false, [](Context &ctx) -> long
+         {
+             ctx.db->exec("BEGIN", nullptr);
+             for (int i = 0; i < ctx.rows; i++)
+             {
+                 Wide model(ctx.db);
+                 model.i0 = i;
+                 model.save();
+             }
+             ctx.db->exec("COMMIT", nullptr);
+             return ctx.rows;
+         }},
+        {"wide_find_all", false, [](Context &ctx) -> long
+         {
+             ctx.db->exec("BEGIN", nullptr);
+             for (int i = 0; i < ctx.rows; i++)
+                 Wide(ctx.db).save();
+             ctx.db->exec("COMMIT", nullptr);
+             Wide probe(ctx.db);
+             return static_cast<long>(probe.findAll<Wide>().size());
+         }},
+        {"static_wide_save", false, [](Context &ctx) -> long
+         {
+             ctx.db->exec("BEGIN", nullptr);
+             for (int i = 0; i < ctx.rows; i++)
+             {
+                 StaticWide model(ctx.db);
+                 model.i0 = i;
+                 model.save();
+             }
+             ctx.db->exec("COMMIT", nullptr);
+             return ctx.rows;
+         }},
+        {"static_wide_find_all", false, [](Context &ctx) -> long
+         {
+             ctx.db->exec("BEGIN", nullptr);
+             for (int i = 0; i < ctx.rows; i++)
+                 StaticWide(ctx.db).save();
+             ctx.db->exec("COMMIT", nullptr);
+             StaticWide probe(ctx.db);
+             return static_cast<long>(probe.findAll<StaticWide>().size());
+         }},
+        {"many_small_models", false, [](Context &ctx) -> long
+         {
+             long count = static_cast<long>(ctx.rows) * 10;
+             for (long i = 0; i < count; i++)
+             {
+                 Small model(ctx.db);
+                 model.age = static_cast<int>(i);
+             }
+             return count;
+         }},
+    };
+}
+
+static void removeFile(const std::string &path)
+{
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+    std::remove((path + "-journal").c_str());
+}
+
+static Options parseOptions(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--rows")
+            options.rows = std::stoi(argv[i + 1]);
+        else if (arg == "--repeat")
+            options.repeat = std::stoi(argv[i + 1]);
+        else if (arg == "--filter")
+            options.filter = argv[i + 1];
+        else if (arg == "--dir")
+            options.dir = argv[i + 1];
+        else
+            throw std::invalid_argument("Unknown option: " + arg);
+    }
+    // The median and best times need at least one run
+    if (options.repeat < 1)
+        throw std::invalid_argument("--repeat must be at least 1");
+    return options;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl
+                  << "Usage: bench [--rows N] [--repeat R] [--filter SUBSTRING] [--dir PATH]" << std::endl;
+        return 2;
+    }
+    std::string diskPath = options.dir + "/sqlmate_bench.db";
+    std::vector<Storage> storages = {
+        {"memory", ":memory:", ""},
+        {"disk", diskPath, ""},
+        {"disk_wal", diskPath, "PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL;"},
+        {"disk_wal_tuned", diskPath, "PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL; PRAGMA cache_size = -65536; PRAGMA temp_store = MEMORY; PRAGMA mmap_size = 268435456;"},
+    };
+
+    for (const Benchmark &benchmark : benchmarks())
+    {
+        for (const Storage &storage : storages)
+        {
+            std::string id = benchmark.name + "/" + storage.name;
+            if (!options.filter.empty() && id.find(options.filter) == std::string::npos)
+                continue;
+
+            std::vector<double> nsPerOp;
+            long ops = 0;
+            for (int r = 0; r < options.repeat; r++)
+            {
+                if (storage.url != ":memory:")
+                    removeFile(storage.url);
+                Context ctx{DatabaseManager::getInstance().connect(storage.url, DatabaseType::SQLITE), options.rows, {}};
+                if (!storage.pragmas.empty())
+                    ctx.db->exec(storage.pragmas, nullptr);
+                if (benchmark.populate)
+                    populate(ctx);
+
+                auto start = std::chrono::steady_clock::now();
+                ops = benchmark.run(ctx);
+                auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                nsPerOp.push_back(elapsed / std::max(ops, 1L));
+
+                DatabaseManager::getInstance().disconnect(storage.url);
+            }
+            if (storage.url != ":memory:")
+                removeFile(storage.url);
+
+            std::sort(nsPerOp.begin(), nsPerOp.end());
+            double median = nsPerOp[nsPerOp.size() / 2];
+            std::cout << "{\"commit\":\"" << SQLMATE_COMMIT << "\""
+                      << ",\"benchmark\":\"" << benchmark.name << "\""
+                      << ",\"storage\":\"" << storage.name << "\""
+                      << ",\"rows\":" << options.rows
+                      << ",\"repeat\":" << options.repeat
+                      << ",\"ops\":" << ops
+                      << ",\"best_ns_per_op\":" << nsPerOp.front()
+                      << ",\"median_ns_per_op\":" << median
+                      << ",\"ops_per_sec\":" << (median > 0 ? 1e9 / median : 0)
+                      << "}" << std::endl;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,2 +1,6 @@
 cd example && \
-rm -rf build
\ No newline at end of file
+rm -rf build
+rm -rf ../bench/build
+rm -rf ../replay/build
+rm -rf ../test/build
+rm -f ../test_output.txt ../bench_output.txt
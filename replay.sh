@@ -0,0 +1,4 @@
+mkdir -p replay/build && \
+cmake -S replay -B replay/build && \
+cmake --build replay/build && \
+./replay/build/replay "$@"
@@ -0,0 +1,498 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <sqlmate.hpp>
+
+using namespace sqlmate;
+
+/**
+ * Replays a workload recorded by `WorkloadCapture` against a copy of a database.
+ *
+ * The statements of each captured thread are replayed in order on one of `concurrency`
+ * connections, either at their original pace or as fast as possible, and the latency
+ * percentiles of the replay are reported along with the captured ones, as JSON lines:
+ * one for the whole workload, then one per SQL text by decreasing total replay time.
+ * The copy is made next to the database and removed afterwards, unless given with `--copy`.
+ * Malformed capture lines, such as a last line cut short by a crash, are skipped and counted.
+ *
+ * Usage: replay CAPTURE DATABASE [--speed original|max] [--concurrency N] [--copy PATH]
+ *                                [--pragmas SQL] [--top N]
+ */
+
+struct Options
+{
+    std::string capture;
+    std::string database;
+    bool originalSpeed = true;
+    int concurrency = 0; ///< One connection per captured thread if 0.
+    std::string copy;    ///< `DATABASE.replay` if empty.
+    bool keepCopy = false;
+    std::string pragmas;
+    int top = 10;
+};
+
+/**
+ * A value bound to a statement. An empty optional stands for NULL.
+ */
+using Value = std::variant<std::optional<int64_t>, int64_t, double, std::string, std::vector<std::byte>>;
+
+struct Event
+{
+    int64_t t = 0;        ///< Start of the statement, in nanoseconds since the capture started.
+    int64_t thread = 0;   ///< The captured thread.
+    int64_t duration = 0; ///< The captured run time, in nanoseconds.
+    std::string sql;
+    std::string expanded;
+    bool hasParams = false;
+    std::vector<Value> params;
+};
+
+struct Sample
+{
+    const Event *event;
+    int64_t duration; ///< The replayed run time, in nanoseconds.
+};
+
+/**
+ * Minimal reader of the JSON lines written by `WorkloadCapture`.
+ */
+class LineParser
+{
+public:
+    LineParser(const std::string &line) : _line(line), _pos(0) {}
+
+    Event parse()
+    {
+        Event event;
+        _expect('{');
+        while (_peek() != '}')
+        {
+            std::string key = _string();
+            _expect(':');
+            if (key == "t")
+                event.t = std::stoll(_number());
+            else if (key == "thread")
+                event.thread = std::stoll(_number());
+            else if (key == "duration")
+                event.duration = std::stoll(_number());
+            else if (key == "sql")
+                event.sql = _string();
+            else if (key == "expanded")
+                event.expanded = _string();
+            else if (key == "params")
+            {
+                event.hasParams = true;
+                _expect('[');
+                while (_peek() != ']')
+                {
+                    event.params.push_back(_value());
+                    if (_peek() == ',')
+                        _pos++;
+                }
+                _pos++;
+            }
+            else
+                _number(); // rows and changes, not replayed
+            if (_peek() == ',')
+                _pos++;
+        }
+        return event;
+    }
+
+private:
+    const std::string &_line;
+    std::size_t _pos;
+
+    char _peek()
+    {
+        while (_pos < _line.size() && std::isspace(static_cast<unsigned char>(_line[_pos])))
+            _pos++;
+        if (_pos >= _line.size())
+            throw std::runtime_error("Unexpected end of line");
+        return _line[_pos];
+    }
+
+    void _expect(char c)
+    {
+        if (_peek() != c)
+            throw std::runtime_error(std::string("Expected '") + c + "' at column " + std::to_string(_pos));
+        _pos++;
+    }
+
+    std::string _number()
+    {
+        _peek();
+        std::size_t start = _pos;
+        while (_pos < _line.size() && std::string_view("+-.0123456789eE").find(_line[_pos]) != std::string_view::npos)
+            _pos++;
+        return _line.substr(start, _pos - start);
+    }
+
+    std::string _string()
+    {
+        std::string text;
+        _expect('"');
+        while (_pos < _line.size() && _line[_pos] != '"')
+        {
+            char c = _line[_pos++];
+            if (c != '\\')
+            {
+                text += c;
+                continue;
+            }
+            c = _line[_pos++];
+            if (c == 'n')
+                text += '\n';
+            else if (c == 't')
+                text += '\t';
+            else if (c == 'u')
+            {
+                text += static_cast<char>(std::stoi(_line.substr(_pos, 4), nullptr, 16));
+                _pos += 4;
+            }
+            else
+                text += c;
+        }
+        _pos++;
+        return text;
+    }
+
+    Value _value()
+    {
+        char c = _peek();
+        if (c == '"')
+            return _string();
+        if (c == 'n')
+        {
+            _pos += 4;
+            return std::optional<int64_t>();
+        }
+        if (c == '{')
+        {
+            _pos++;
+            std::string kind = _string();
+            _expect(':');
+            std::vector<std::byte> bytes;
+            if (kind == "zeroblob")
+                bytes.resize(std::stoull(_number()));
+            else
+            {
+                std::string hex = _string();
+                for (std::size_t i = 0; i + 1 < hex.size(); i += 2)
+                    bytes.push_back(static_cast<std::byte>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+            }
+            _expect('}');
+            return bytes;
+        }
+        std::string number = _number();
+        if (number.find_first_of(".eE") != std::string::npos)
+            return std::stod(number);
+        return static_cast<int64_t>(std::stoll(number));
+    }
+};
+
+static int integerOption(const std::string &arg, const std::string &value)
+{
+    try
+    {
+        std::size_t end = 0;
+        int number = std::stoi(value, &end);
+        if (end == value.size())
+            return number;
+    }
+    catch (const std::exception &)
+    {
+    }
+    throw std::invalid_argument(arg + " expects an integer, got " + value);
+}
+
+static Options parseOptions(int argc, char **argv)
+{
+    Options options;
+    if (argc < 3)
+        throw std::invalid_argument("Missing CAPTURE or DATABASE");
+    options.capture = argv[1];
+    options.database = argv[2];
+    for (int i = 3; i < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (i + 1 == argc)
+            throw std::invalid_argument("Missing value for " + arg);
+        if (arg == "--speed")
+        {
+            std::string speed = argv[i + 1];
+            if (speed != "original" && speed != "max")
+                throw std::invalid_argument("--speed must be original or max");
+            options.originalSpeed = (speed == "original");
+        }
+        else if (arg == "--concurrency")
+            options.concurrency = integerOption(arg, argv[i + 1]);
+        else if (arg == "--copy")
+            options.copy = argv[i + 1];
+        else if (arg == "--pragmas")
+            options.pragmas = argv[i + 1];
+        else if (arg == "--top")
+            options.top = integerOption(arg, argv[i + 1]);
+        else
+            throw std::invalid_argument("Unknown option: " + arg);
+    }
+    if (options.concurrency < 0 || options.top < 0)
+        throw std::invalid_argument("--concurrency and --top must not be negative");
+    options.keepCopy = !options.copy.empty();
+    if (options.copy.empty())
+        options.copy = options.database + ".replay";
+    return options;
+}
+
+static std::vector<Event> readCapture(const std::string &path, long &skipped)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("Unable to open capture: " + path);
+
+    std::vector<Event> events;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty())
+            continue;
+        try
+        {
+            events.push_back(LineParser(line).parse());
+        }
+        catch (const std::exception &)
+        {
+            skipped++;
+        }
+    }
+    // Completion order to start order, as replayed
+    std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b)
+                     { return a.t < b.t; });
+    return events;
+}
+
+/**
+ * Copies the database and its write-ahead log, so that the replay never touches the original.
+ */
+static void copyDatabase(const std::string &from, const std::string &to)
+{
+    for (const char *suffix : {"", "-wal", "-shm", "-journal"})
+        std::remove((to + suffix).c_str());
+    for (const char *suffix : {"", "-wal"})
+    {
+        std::ifstream in(from + suffix, std::ios::binary);
+        if (!in)
+        {
+            if (*suffix)
+                continue;
+            throw std::runtime_error("Unable to open database: " + from);
+        }
+        std::ofstream out(to + suffix, std::ios::binary);
+        out << in.rdbuf();
+    }
+}
+
+static std::vector<FieldInfo> bindings(Event &event)
+{
+    std::vector<FieldInfo> params;
+    for (Value &value : event.params)
+        std::visit([&](auto &v)
+                   { params.push_back(FieldInfo(std::ref(v), typeid(v))); },
+                   value);
+    return params;
+}
+
+/**
+ * Replays the statements of a queue; a failure other than a failed statement stops the thread and is
+ * handed to the main thread.
+ */
+static void replayThread(const Options &options, std::vector<Event *> events, std::chrono::steady_clock::time_point start,
+                         std::vector<Sample> &samples, std::atomic<long> &errors, std::exception_ptr &failure)
+{
+    try
+    {
+        auto db = std::make_shared<SQLite>();
+        db->connect(options.copy);
+        if (!options.pragmas.empty())
+            db->exec(options.pragmas, nullptr);
+
+        for (Event *event : events)
+        {
+            if (options.originalSpeed)
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(event->t));
+
+            std::vector<FieldInfo> params = event->hasParams ? bindings(*event) : std::vector<FieldInfo>();
+            auto began = std::chrono::steady_clock::now();
+            try
+            {
+                if (event->hasParams)
+                    db->exec(event->sql, params, nullptr);
+                else
+                    db->exec(event->expanded.empty() ? event->sql : event->expanded, nullptr);
+            }
+            catch (const DatabaseError &)
+            {
+                errors++;
+            }
+            samples.push_back({event, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - began).count()});
+        }
+        db->disconnect();
+    }
+    catch (...)
+    {
+        failure = std::current_exception();
+    }
+}
+
+/**
+ * Removes the copy of the database on destruction, unless it was given with `--copy`.
+ */
+struct CopyGuard
+{
+    const Options &options;
+
+    ~CopyGuard()
+    {
+        if (!options.keepCopy)
+            for (const char *suffix : {"", "-wal", "-shm", "-journal"})
+                std::remove((options.copy + suffix).c_str());
+    }
+};
+
+static int64_t percentile(const std::vector<int64_t> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    std::size_t rank = static_cast<std::size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static std::string escape(const std::string &text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += (c == '\n' || c == '\t') ? ' ' : c;
+    }
+    return escaped;
+}
+
+static void report(const std::string &label, std::vector<int64_t> replayed, std::vector<int64_t> captured, long errors)
+{
+    std::sort(replayed.begin(), replayed.end());
+    std::sort(captured.begin(), captured.end());
+    int64_t total = 0;
+    for (int64_t duration : replayed)
+        total += duration;
+
+    std::cout << "{" << label
+              << ",\"statements\":" << replayed.size()
+              << ",\"errors\":" << errors
+              << ",\"total_us\":" << total / 1000;
+    for (double p : {50.0, 90.0, 99.0, 99.9})
+        std::cout << ",\"p" << p << "_us\":" << percentile(replayed, p) / 1000.0
+                  << ",\"captured_p" << p << "_us\":" << percentile(captured, p) / 1000.0;
+    std::cout << ",\"max_us\":" << (replayed.empty() ? 0 : replayed.back()) / 1000.0
+              << ",\"captured_max_us\":" << (captured.empty() ? 0 : captured.back()) / 1000.0
+              << "}" << std::endl;
+}
+
+static int replay(const Options &options)
+{
+    long skipped = 0;
+    std::vector<Event> events = readCapture(options.capture, skipped);
+    if (skipped)
+        std::cerr << "Skipped " << skipped << " malformed lines of " << options.capture << std::endl;
+    CopyGuard guard{options};
+    copyDatabase(options.database, options.copy);
+
+    // The statements of a captured thread stay in order on the same connection
+    std::unordered_map<int64_t, int> threads;
+    for (const Event &event : events)
+        threads.insert({event.thread, static_cast<int>(threads.size())});
+    int concurrency = options.concurrency > 0 ? options.concurrency : std::max(1, static_cast<int>(threads.size()));
+    std::vector<std::vector<Event *>> queues(concurrency);
+    for (Event &event : events)
+        queues[threads[event.thread] % concurrency].push_back(&event);
+
+    std::vector<std::vector<Sample>> samples(concurrency);
+    std::atomic<long> errors{0};
+    std::vector<std::exception_ptr> failures(concurrency);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < concurrency; i++)
+        workers.emplace_back(replayThread, std::cref(options), queues[i], start, std::ref(samples[i]), std::ref(errors), std::ref(failures[i]));
+    for (std::thread &worker : workers)
+        worker.join();
+    for (const std::exception_ptr &failure : failures)
+        if (failure)
+            std::rethrow_exception(failure);
+    auto wall = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<int64_t> replayed, captured;
+    std::unordered_map<std::string, std::pair<std::vector<int64_t>, std::vector<int64_t>>> perStatement;
+    for (const auto &thread : samples)
+        for (const Sample &sample : thread)
+        {
+            replayed.push_back(sample.duration);
+            captured.push_back(sample.event->duration);
+            auto &statement = perStatement[sample.event->sql];
+            statement.first.push_back(sample.duration);
+            statement.second.push_back(sample.event->duration);
+        }
+
+    report("\"scope\":\"workload\",\"speed\":\"" + std::string(options.originalSpeed ? "original" : "max") +
+               "\",\"concurrency\":" + std::to_string(concurrency) + ",\"wall_ms\":" + std::to_string(wall) +
+               ",\"skipped\":" + std::to_string(skipped),
+           replayed, captured, errors);
+
+    std::vector<std::pair<int64_t, const std::string *>> ranking;
+    for (const auto &[sql, durations] : perStatement)
+    {
+        int64_t total = 0;
+        for (int64_t duration : durations.first)
+            total += duration;
+        ranking.push_back({total, &sql});
+    }
+    std::sort(ranking.begin(), ranking.end(), [](const auto &a, const auto &b)
+              { return a.first > b.first; });
+    for (int i = 0; i < options.top && i < static_cast<int>(ranking.size()); i++)
+    {
+        const auto &durations = perStatement[*ranking[i].second];
+        report("\"scope\":\"statement\",\"sql\":\"" + escape(*ranking[i].second) + "\"", durations.first, durations.second, 0);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl
+                  << "Usage: replay CAPTURE DATABASE [--speed original|max] [--concurrency N] [--copy PATH] [--pragmas SQL] [--top N]" << std::endl;
+        return 2;
+    }
+    try
+    {
+        return replay(options);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
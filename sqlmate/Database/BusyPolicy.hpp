@@ -0,0 +1,38 @@
+/**
+ * @file BusyPolicy.hpp
+ * @brief Defines the lock contention handling types in the sqlmate namespace.
+ */
+
+#include <chrono>
+#include <cstdint>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @struct BusyPolicy
+     * @brief Describes how a connection waits for the locks held by other connections.
+     */
+    struct BusyPolicy
+    {
+        std::chrono::milliseconds timeout{5000};      /**< Total time a statement waits for a lock before failing with `BusyError`. */
+        bool backoff = true;                          /**< True to wait with jittered exponential backoff, false to use the database's own busy timeout. */
+        std::chrono::microseconds initialDelay{100};  /**< The first backoff delay, doubled after each attempt. */
+        std::chrono::microseconds maxDelay{20000};    /**< The upper bound of a backoff delay. */
+        bool immediateTransactions = true;            /**< True to start plain `BEGIN` transactions as `BEGIN IMMEDIATE`. */
+    };
+
+    /**
+     * @struct BusyStats
+     * @brief Lock contention counters of a connection.
+     *
+     * Only waits made with `BusyPolicy::backoff` enabled are counted.
+     */
+    struct BusyStats
+    {
+        int64_t waits = 0;                       /**< Number of times the connection waited for a lock. */
+        std::chrono::microseconds waitTime{0};   /**< Total time spent waiting for locks. */
+        int64_t timeouts = 0;                    /**< Number of statements that gave up waiting. */
+    };
+} // namespace sqlmate
@@ -0,0 +1,42 @@
+/**
+ * @file ChangeEvent.hpp
+ * @brief Defines the change data capture types in the sqlmate namespace.
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @enum ChangeOperation
+     * @brief Enum representing the kinds of row changes.
+     */
+    enum ChangeOperation
+    {
+        ROW_INSERTED, ///< The row was inserted.
+        ROW_UPDATED,  ///< The row was updated.
+        ROW_DELETED   ///< The row was deleted.
+    };
+
+    /**
+     * @struct ChangeEvent
+     * @brief Describes a committed change of a row.
+     */
+    struct ChangeEvent
+    {
+        std::string table;   /**< The name of the table holding the row. */
+        ChangeOperation op;  /**< The kind of change. */
+        int64_t rowid;       /**< The rowid (`_id`) of the row. */
+    };
+
+    /**
+     * @typedef change_callback
+     * @brief Alias for a callback receiving the changes of a committed transaction, in order.
+     */
+    typedef std::function<void(const std::vector<ChangeEvent> &)> change_callback;
+} // namespace sqlmate
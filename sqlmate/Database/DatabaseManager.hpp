@@ -7,6 +7,7 @@
 #include <memory>
 #include "./IDatabase.hpp"
 #include "./SQLite/SQLite.hpp"
+#include "./Sharded/ShardedDatabase.hpp"
 
 #pragma once
 
@@ -56,6 +57,10 @@ namespace sqlmate
          * @brief Connects to a database using the specified URL and type.
          * 
          * If the database is not registered, it will be registered first.
+         * For SQLite, `:memory:` and `file::memory:?cache=shared` open an in-memory database, which can
+         * be persisted and reloaded with `IDatabase::snapshotTo()` and `IDatabase::restoreFrom()`.
+         * 
+         * A database already connected is returned as is, keeping its handle and content.
          * 
          * @param url The URL or path of the database.
          * @param type The type of the database (e.g., SQLITE).
@@ -66,7 +71,34 @@ namespace sqlmate
         {
             if (!isRegistered(url))
                 registerDatabase(url, type);
-            databases[url]->connect(url);
+            if (!databases[url]->isConnected())
+                databases[url]->connect(url);
+            return (databases[url]);
+        }
+
+        /**
+         * @brief Connects to a database sharded across several files, see `ShardedDatabase`.
+         * 
+         * If the database is not registered, it will be registered first, with one database of
+         * the given type per shard. Shard `i` of `data.db` is stored in `data.i.db`.
+         * 
+         * @param url The path of the logical database.
+         * @param type The type of the databases holding the shards (e.g., SQLITE).
+         * @param shards The number of shards.
+         * @return A shared pointer to the connected database.
+         * @throw DatabaseError If a shard connection fails.
+         */
+        std::shared_ptr<IDatabase> connect(const std::string &url, DatabaseType type, std::size_t shards)
+        {
+            if (!isRegistered(url))
+            {
+                std::vector<std::shared_ptr<IDatabase>> instances;
+                for (std::size_t i = 0; i < shards; i++)
+                    instances.push_back(createDatabase(url, type));
+                databases.insert({url, std::make_shared<ShardedDatabase>(instances)});
+            }
+            if (!databases[url]->isConnected())
+                databases[url]->connect(url);
             return (databases[url]);
         }
 
@@ -124,15 +156,26 @@ namespace sqlmate
          * @throw DatabaseError If the database type is unsupported.
          */
         void registerDatabase(const std::string &url, DatabaseType type)
+        {
+            databases.insert({url, createDatabase(url, type)});
+        }
+
+        /**
+         * @brief Creates a disconnected database of the specified type.
+         * 
+         * @param url The URL or path of the database, for error reporting.
+         * @param type The type of the database (e.g., SQLITE).
+         * @return A shared pointer to the database.
+         * @throw DatabaseError If the database type is unsupported.
+         */
+        std::shared_ptr<IDatabase> createDatabase(const std::string &url, DatabaseType type)
         {
             switch (type)
             {
             case DatabaseType::SQLITE:
-                databases.insert({url, std::make_shared<SQLite>()});
-                break;
+                return (std::make_shared<SQLite>());
             default:
                 throw DatabaseError("Unable to register database: " + url);
-                break;
             }
         }
     };
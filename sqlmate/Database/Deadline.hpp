@@ -0,0 +1,124 @@
+/**
+ * @file Deadline.hpp
+ * @brief Defines the query deadline and cancellation types in the sqlmate namespace.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @class CancellationToken
+     * @brief Lets any thread cancel the queries run under it.
+     *
+     * Copies share the same state, so a token can be handed to another thread and cancelled from there.
+     */
+    class CancellationToken
+    {
+    public:
+        CancellationToken() : _cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+        /**
+         * @brief Cancels the queries running or about to run under the token.
+         */
+        void cancel() { *_cancelled = true; }
+
+        /**
+         * @brief Checks whether the token was cancelled.
+         */
+        bool isCancelled() const { return (*_cancelled); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> _cancelled; ///< The state shared by the copies of the token.
+    };
+
+    /**
+     * @struct QueryDeadline
+     * @brief The deadline and cancellation token applying to the current queries of a thread.
+     */
+    struct QueryDeadline
+    {
+        bool active = false;                              /**< Whether a deadline or a token applies. */
+        std::chrono::steady_clock::time_point deadline{}; /**< When the queries must have completed. */
+        std::shared_ptr<CancellationToken> token;         /**< The token cancelling the queries, if any. */
+
+        /**
+         * @brief Returns the deadline of the calling thread.
+         */
+        static QueryDeadline &current()
+        {
+            static thread_local QueryDeadline deadline;
+            return (deadline);
+        }
+    };
+
+    /**
+     * @class DeadlineScope
+     * @brief Bounds the queries run by the calling thread for its lifetime.
+     *
+     * Applies to every query, raw or issued by a model, started before the scope ends. Nested
+     * scopes cannot extend the deadline of an enclosing scope.
+     */
+    class DeadlineScope
+    {
+    public:
+        /**
+         * @brief Bounds the queries of the calling thread by a timeout, and optionally a token.
+         *
+         * @param timeout The time left for the queries to complete, from now.
+         * @param token A token cancelling the queries when triggered.
+         */
+        DeadlineScope(std::chrono::steady_clock::duration timeout, const CancellationToken &token)
+            : DeadlineScope(std::chrono::steady_clock::now() + timeout, std::make_shared<CancellationToken>(token))
+        {
+        }
+
+        /**
+         * @brief Bounds the queries of the calling thread by a timeout.
+         *
+         * @param timeout The time left for the queries to complete, from now.
+         */
+        DeadlineScope(std::chrono::steady_clock::duration timeout)
+            : DeadlineScope(std::chrono::steady_clock::now() + timeout, nullptr)
+        {
+        }
+
+        /**
+         * @brief Lets a token cancel the queries of the calling thread, without deadline.
+         *
+         * @param token A token cancelling the queries when triggered.
+         */
+        DeadlineScope(const CancellationToken &token)
+            : DeadlineScope(std::chrono::steady_clock::time_point::max(), std::make_shared<CancellationToken>(token))
+        {
+        }
+
+        ~DeadlineScope()
+        {
+            QueryDeadline::current() = _previous;
+        }
+
+        DeadlineScope(DeadlineScope const &) = delete;
+        void operator=(DeadlineScope const &) = delete;
+
+    private:
+        DeadlineScope(std::chrono::steady_clock::time_point deadline, std::shared_ptr<CancellationToken> token)
+            : _previous(QueryDeadline::current())
+        {
+            QueryDeadline &current = QueryDeadline::current();
+            if (_previous.active && _previous.deadline < deadline)
+                deadline = _previous.deadline;
+            current.active = true;
+            current.deadline = deadline;
+            // The innermost token wins, an enclosing one being kept when none is given
+            if (token)
+                current.token = token;
+        }
+
+        QueryDeadline _previous; ///< The deadline to restore.
+    };
+} // namespace sqlmate
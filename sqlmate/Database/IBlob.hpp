@@ -0,0 +1,52 @@
+/**
+ * @file IBlob.hpp
+ * @brief Defines the abstract interface for incremental BLOB I/O in the sqlmate namespace.
+ */
+
+#include <cstddef>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @class IBlob
+     * @brief Abstract handle on a single BLOB value stored in the database.
+     *
+     * Gives random access to the bytes of the BLOB without loading it in memory.
+     * A BLOB cannot be resized through its handle: its size is set when the row is written.
+     */
+    class IBlob
+    {
+    public:
+        /**
+         * @brief Virtual destructor, closing the handle in derived classes.
+         */
+        virtual ~IBlob() = default;
+
+        /**
+         * @brief Returns the size of the BLOB in bytes.
+         */
+        virtual std::size_t size() const = 0;
+
+        /**
+         * @brief Reads bytes from the BLOB.
+         *
+         * @param offset The offset of the first byte to read.
+         * @param buffer The buffer receiving the bytes.
+         * @param length The number of bytes to read.
+         * @throw DatabaseError If the range is out of the BLOB or the read fails.
+         */
+        virtual void read(std::size_t offset, void *buffer, std::size_t length) const = 0;
+
+        /**
+         * @brief Writes bytes into the BLOB.
+         *
+         * @param offset The offset of the first byte to write.
+         * @param data The bytes to write.
+         * @param length The number of bytes to write.
+         * @throw DatabaseError If the range is out of the BLOB, the handle is read-only or the write fails.
+         */
+        virtual void write(std::size_t offset, const void *data, std::size_t length) = 0;
+    };
+} // namespace sqlmate
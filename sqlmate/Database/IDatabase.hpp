@@ -6,6 +6,18 @@
 #include <iostream>
 #include <memory>
 #include <functional>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include "./IBlob.hpp"
+#include "./IQueryObserver.hpp"
+#include "./QueryPlan.hpp"
+#include "./ChangeEvent.hpp"
+#include "./MemoryStats.hpp"
+#include "./BusyPolicy.hpp"
+#include "./SchemaChanges.hpp"
+#include "./Deadline.hpp"
+#include "./Result.hpp"
 #include "../Exceptions/Database.hpp"
 #include "../Exceptions/QueryBuilder.hpp"
 #include "../QueryBuilder/QueryBuilder.hpp"
@@ -44,6 +56,150 @@ namespace sqlmate
         db_callback _func;
     };
 
+    /**
+     * @class IRow
+     * @brief Typed, read-only access to the current row of a query result.
+     * 
+     * Values are read in their native storage type, without going through text.
+     * Views and pointers returned by a row are only valid until the callback returns.
+     */
+    class IRow
+    {
+    public:
+        virtual ~IRow() = default;
+
+        /**
+         * @brief Returns the number of columns of the row.
+         */
+        virtual int columnCount() const = 0;
+
+        /**
+         * @brief Returns the name of a column.
+         */
+        virtual const char *columnName(int col) const = 0;
+
+        /**
+         * @brief Checks whether a column holds NULL.
+         */
+        virtual bool isNull(int col) const = 0;
+
+        /**
+         * @brief Reads a column as a 64-bit integer.
+         */
+        virtual int64_t getInt64(int col) const = 0;
+
+        /**
+         * @brief Reads a column as a double.
+         */
+        virtual double getDouble(int col) const = 0;
+
+        /**
+         * @brief Reads a column as text.
+         */
+        virtual std::string_view getText(int col) const = 0;
+
+        /**
+         * @brief Reads a column as a BLOB.
+         * 
+         * @param col The index of the column.
+         * @param size Set to the size of the BLOB in bytes.
+         * @return A pointer to the BLOB's bytes, or `nullptr` if it is empty.
+         */
+        virtual const std::byte *getBlob(int col, std::size_t &size) const = 0;
+    };
+
+    /**
+     * @typedef row_callback
+     * @brief Alias for a callback receiving typed rows.
+     * 
+     * The function is called once per result row and should return 0 to continue,
+     * any other value aborting the query.
+     */
+    typedef std::function<int(IRow &)> row_callback;
+
+    class RowCallBackWrapper
+    {
+    public:
+        RowCallBackWrapper(row_callback cb) : _func(cb)
+        {
+        }
+
+        row_callback get()
+        {
+            return _func;
+        }
+
+    private:
+        row_callback _func;
+    };
+
+    /**
+     * @class IParams
+     * @brief Typed, write-only access to the parameters of a prepared statement.
+     * 
+     * Values are bound in their native storage type, without going through `FieldInfo`.
+     * Text and BLOB values are not copied and must outlive the execution of the statement.
+     */
+    class IParams
+    {
+    public:
+        virtual ~IParams() = default;
+
+        /**
+         * @brief Binds NULL to a parameter.
+         * 
+         * @param index The 1-based index of the parameter.
+         */
+        virtual void bindNull(int index) = 0;
+
+        /**
+         * @brief Binds a 64-bit integer to a parameter.
+         */
+        virtual void bindInt64(int index, int64_t value) = 0;
+
+        /**
+         * @brief Binds a double to a parameter.
+         */
+        virtual void bindDouble(int index, double value) = 0;
+
+        /**
+         * @brief Binds text to a parameter.
+         */
+        virtual void bindText(int index, std::string_view value) = 0;
+
+        /**
+         * @brief Binds a BLOB to a parameter.
+         */
+        virtual void bindBlob(int index, const void *data, std::size_t size) = 0;
+
+        /**
+         * @brief Binds a zero-filled BLOB of the given size to a parameter.
+         */
+        virtual void bindZeroBlob(int index, std::size_t size) = 0;
+    };
+
+    /**
+     * @typedef bind_callback
+     * @brief Alias for a callback binding the parameters of a statement.
+     */
+    typedef std::function<void(IParams &)> bind_callback;
+
+    class BindCallBackWrapper
+    {
+    public:
+        BindCallBackWrapper(bind_callback cb) : _func(cb)
+        {
+        }
+
+        const bind_callback &get() const
+        {
+            return _func;
+        }
+
+    private:
+        bind_callback _func;
+    };
+
     /**
      * @class IDatabase
      * @brief Abstract interface for database operations.
@@ -90,6 +246,208 @@ namespace sqlmate
          */
         virtual void exec(std::string query, QueryCallBackWrapper *cb_wrapper) = 0;
 
+        /**
+         * @brief Executes a single SQL statement with bound parameters and an optional typed row callback.
+         * 
+         * @param query The SQL statement, with positional `?` placeholders.
+         * @param params The values bound to the placeholders, in order.
+         * @param cb_wrapper A callback function to handle result rows, or `nullptr` if not used.
+         * @throw DatabaseError If the statement execution fails.
+         */
+        virtual void exec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper) = 0;
+
+        /**
+         * @brief Executes a single SQL statement whose parameters are bound by a callback.
+         * 
+         * Lets callers that know their parameter types at compile time bind them directly.
+         * 
+         * @param query The SQL statement, with positional `?` placeholders.
+         * @param binder The callback binding the parameters.
+         * @param cb_wrapper A callback function to handle result rows, or `nullptr` if not used.
+         * @throw DatabaseError If the statement execution fails.
+         */
+        virtual void exec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper) = 0;
+
+        /**
+         * @brief Executes a database query, returning failures instead of throwing them.
+         * 
+         * Behaves like `exec()`, except that database failures are returned as an `Error`
+         * holding the result code of the database, without allocating. Exceptions thrown by
+         * the callback still propagate.
+         * 
+         * @param query The SQL query to execute.
+         * @param cb_wrapper A callback function to handle query results, or `nullptr` if not used.
+         * @return A success, or the error that stopped the query.
+         */
+        virtual Result<void> tryExec(const std::string &query, QueryCallBackWrapper *cb_wrapper) = 0;
+
+        /**
+         * @brief Executes a single SQL statement with bound parameters, returning failures instead of throwing them.
+         * 
+         * @param query The SQL statement, with positional `?` placeholders.
+         * @param params The values bound to the placeholders, in order.
+         * @param cb_wrapper A callback function to handle result rows, or `nullptr` if not used.
+         * @return A success, or the error that stopped the statement.
+         */
+        virtual Result<void> tryExec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper) = 0;
+
+        /**
+         * @brief Executes a single SQL statement whose parameters are bound by a callback, returning failures instead of throwing them.
+         * 
+         * @param query The SQL statement, with positional `?` placeholders.
+         * @param binder The callback binding the parameters.
+         * @param cb_wrapper A callback function to handle result rows, or `nullptr` if not used.
+         * @return A success, or the error that stopped the statement.
+         */
+        virtual Result<void> tryExec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper) = 0;
+
+        /**
+         * @brief Returns the number of rows inserted, updated or deleted by the last such statement
+         *        executed on the database.
+         * 
+         * The count belongs to the connection, not to the calling thread: threads sharing a database
+         * must read it before another thread runs a statement. `ShardedDatabase` keeps a count per
+         * calling thread, since its shards are shared by every thread.
+         */
+        virtual int64_t changes() = 0;
+
+        /**
+         * @brief Opens a handle for incremental I/O on a BLOB value.
+         * 
+         * @param table The name of the table holding the BLOB.
+         * @param column The name of the BLOB column.
+         * @param rowid The rowid (`_id`) of the row holding the BLOB.
+         * @param writable True to open the handle for writing, false for read-only access.
+         * @return A handle on the BLOB.
+         * @throw DatabaseError If the BLOB cannot be opened.
+         */
+        virtual std::shared_ptr<IBlob> openBlob(const std::string &table, const std::string &column, int64_t rowid, bool writable) = 0;
+
+        /**
+         * @brief Installs an observer notified of every executed statement.
+         * 
+         * Statement profiling is only enabled while an observer is installed.
+         * 
+         * @param observer The observer, or `nullptr` to remove the current one.
+         */
+        virtual void setObserver(std::shared_ptr<IQueryObserver> observer) = 0;
+
+        /**
+         * @brief Enables or disables the query plan analysis diagnostic mode.
+         * 
+         * While enabled, the plan of each distinct statement is computed and classified the first
+         * time the statement runs, and reported along with the model type and call site that ran it.
+         * 
+         * @param reporter The callback receiving the plans, or `nullptr` to disable the analysis.
+         * @param offendersOnly True to only report plans with a full scan or a temporary B-tree.
+         */
+        virtual void setPlanAnalyzer(plan_callback reporter, bool offendersOnly = true) = 0;
+
+        /**
+         * @brief Copies the whole database to a file, incrementally.
+         * 
+         * The copy is made a few pages at a time so that writers are only blocked for the duration
+         * of one step, and is written to a temporary file renamed over `path` once complete.
+         * 
+         * @param path The path of the snapshot file.
+         * @param pagesPerStep The number of pages copied per step.
+         * @throw DatabaseError If the snapshot fails.
+         */
+        virtual void snapshotTo(const std::string &path, int pagesPerStep = 256) = 0;
+
+        /**
+         * @brief Replaces the content of the database with a snapshot file, incrementally.
+         * 
+         * @param path The path of the snapshot file.
+         * @param pagesPerStep The number of pages copied per step.
+         * @throw DatabaseError If the restore fails.
+         */
+        virtual void restoreFrom(const std::string &path, int pagesPerStep = 256) = 0;
+
+        /**
+         * @brief Brings the columns of a table in line with the fields of a model.
+         * 
+         * Missing columns are added in place, which only rewrites the schema. If a column type or the
+         * `_id` key differs from the model, the table is rebuilt when `SchemaOptions::rebuild` is set:
+         * the rows are copied to a new table in batches, each in its own transaction, then the new
+         * table replaces the old one along with its indexes and triggers. Columns the model lacks are kept.
+         * 
+         * @param table The name of the table, which must exist.
+         * @param columns A map of the column names of the model to their field information.
+         * @param options Whether and how the table may be rebuilt.
+         * @return The changes made to the table.
+         * @throw DatabaseError If a change fails, the table being left as it was.
+         */
+        virtual SchemaChanges evolveTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns,
+                                          const SchemaOptions &options = SchemaOptions()) = 0;
+
+        /**
+         * @brief Subscribes to the committed changes of a table.
+         * 
+         * Changes are buffered while a transaction is open and delivered in one batch, in order,
+         * once it is committed; changes of rolled back transactions are never delivered.
+         * Callbacks run on the thread that committed, after the committing query returns.
+         * 
+         * @param table The name of the table to watch, or an empty string for all tables.
+         * @param cb The callback receiving the batches of changes.
+         * @return The identifier of the subscription, to pass to `unsubscribe()`.
+         */
+        virtual int subscribe(const std::string &table, change_callback cb) = 0;
+
+        /**
+         * @brief Cancels a subscription.
+         * 
+         * @param subscription The identifier returned by `subscribe()`.
+         */
+        virtual void unsubscribe(int subscription) = 0;
+
+        /**
+         * @brief Returns the memory usage of the database engine, of this connection and of the library.
+         */
+        virtual MemoryStats memoryStats() = 0;
+
+        /**
+         * @brief Sets how the connection waits for the locks held by other connections.
+         * 
+         * Statements that still cannot get their lock once the policy's timeout has elapsed
+         * fail with `BusyError`.
+         * 
+         * @param policy The busy handling policy.
+         */
+        virtual void setBusyPolicy(const BusyPolicy &policy) = 0;
+
+        /**
+         * @brief Returns the lock contention counters of the connection.
+         */
+        virtual BusyStats busyStats() = 0;
+
+        /**
+         * @brief Sets the time each query may run before it is interrupted.
+         * 
+         * Applies to every `exec` call of the connection, along with the deadlines set by `DeadlineScope`
+         * on the calling thread, the earliest deadline winning.
+         * 
+         * @param timeout The time budget of a query, or zero to disable it.
+         */
+        virtual void setQueryTimeout(std::chrono::milliseconds timeout) = 0;
+
+        /**
+         * @brief Interrupts the query running on the connection, if any.
+         * 
+         * Can be called from any thread; the interrupted query fails with `QueryCancelledError`.
+         */
+        virtual void interrupt() = 0;
+
+        /**
+         * @brief Returns the database holding the rows of a shard key.
+         * 
+         * Databases made of a single file hold every row and return themselves, see `ShardedDatabase`.
+         * 
+         * @param key The hash of the shard key of a row.
+         * @return The database holding the rows of the key.
+         */
+        virtual IDatabase &shard(uint64_t key) = 0;
+
     public:
         /**
          * @brief Shared pointer to an `IQueryBuilder` for constructing SQL queries.
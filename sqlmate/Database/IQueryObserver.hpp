@@ -0,0 +1,61 @@
+/**
+ * @file IQueryObserver.hpp
+ * @brief Defines the interface observing the statements executed by a database in the sqlmate namespace.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "../QueryBuilder/QueryBuilder.hpp"
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @struct QueryEvent
+     * @brief Describes one completed run of a statement.
+     *
+     * Pointers are only valid for the duration of the observer call.
+     */
+    struct QueryEvent
+    {
+        const char *sql;                      /**< The SQL text of the statement, with its placeholders. */
+        const std::vector<FieldInfo> *params; /**< The values bound to the statement, or `nullptr` for unparameterized queries. */
+        std::chrono::nanoseconds duration;    /**< The time spent running the statement, from its first step to its completion. */
+        int64_t rowsReturned;                 /**< The number of rows returned by the statement. */
+        int64_t rowsChanged;                  /**< The number of rows inserted, updated or deleted by the statement, triggers included. */
+        bool cacheHit;                        /**< True if the prepared statement was reused from the statement cache. */
+        const char *expandedSql;              /**< The SQL text with its bound values inlined, for statements bound without `params`, if the observer asked for it with `wantsExpandedSql()`. */
+    };
+
+    /**
+     * @class IQueryObserver
+     * @brief Interface notified of every statement executed by an `IDatabase`.
+     *
+     * The observer is called synchronously on the thread executing the statement,
+     * so implementations should be cheap and thread-safe.
+     */
+    class IQueryObserver
+    {
+    public:
+        /**
+         * @brief Virtual destructor for proper cleanup of derived classes.
+         */
+        virtual ~IQueryObserver() = default;
+
+        /**
+         * @brief Called once each time a statement finishes running.
+         *
+         * @param event The description of the run.
+         */
+        virtual void onQuery(const QueryEvent &event) = 0;
+
+        /**
+         * @brief Tells whether the events should carry the SQL text with bound values inlined.
+         *
+         * Expanding the text has a cost, so it is only done for observers asking for it.
+         */
+        virtual bool wantsExpandedSql() const { return (false); }
+    };
+} // namespace sqlmate
@@ -0,0 +1,58 @@
+/**
+ * @file MemoryStats.hpp
+ * @brief Defines the memory accounting types in the sqlmate namespace.
+ */
+
+#include <atomic>
+#include <cstdint>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @struct MemoryStats
+     * @brief Memory usage of the database engine, of a connection and of the library.
+     *
+     * All sizes are in bytes unless stated otherwise.
+     */
+    struct MemoryStats
+    {
+        int64_t memoryUsed = 0;        /**< Memory currently allocated by the database engine, process-wide. */
+        int64_t memoryHighwater = 0;   /**< Highest value reached by `memoryUsed`. */
+        int64_t mallocCount = 0;       /**< Number of live allocations of the database engine, process-wide. */
+        int64_t pageCacheUsed = 0;     /**< Number of page cache slots used in the preallocated page cache, process-wide. */
+        int64_t pageCacheOverflow = 0; /**< Page cache memory that did not fit in the preallocated page cache, process-wide. */
+        int64_t cacheUsed = 0;         /**< Page cache memory used by the connection. */
+        int64_t schemaUsed = 0;        /**< Memory used by the connection to store the database schema. */
+        int64_t statementsUsed = 0;    /**< Memory used by the prepared statements of the connection. */
+        int64_t lookasideUsed = 0;     /**< Number of lookaside slots used by the connection. */
+        int64_t liveModels = 0;        /**< Number of model instances alive in the process. */
+        int64_t cachedStatements = 0;  /**< Number of prepared statements kept in the connection's cache. */
+        int64_t bufferedChanges = 0;   /**< Number of change events buffered for subscribers and not delivered yet. */
+    };
+
+    /**
+     * @class LiveModelCounter
+     * @brief Counts the model instances alive in the process.
+     *
+     * Embedded as a member of every model, so that copies are counted as well.
+     */
+    class LiveModelCounter
+    {
+    public:
+        LiveModelCounter() { count()++; }
+        LiveModelCounter(const LiveModelCounter &) { count()++; }
+        LiveModelCounter &operator=(const LiveModelCounter &) = default;
+        ~LiveModelCounter() { count()--; }
+
+        /**
+         * @brief Returns the number of model instances alive in the process.
+         */
+        static std::atomic<int64_t> &count()
+        {
+            static std::atomic<int64_t> liveModels{0};
+            return (liveModels);
+        }
+    };
+} // namespace sqlmate
@@ -0,0 +1,213 @@
+/**
+ * @file QueryMetrics.hpp
+ * @brief Provides a query observer aggregating statement metrics in the sqlmate namespace.
+ */
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "./IQueryObserver.hpp"
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @class QueryMetrics
+     * @brief Query observer recording latency histograms, row counters and a slow query log.
+     *
+     * Install it with `IDatabase::setObserver()` and call `snapshot()` periodically to export
+     * the figures to a metrics system. Statistics are aggregated per SQL text. Queries inlining
+     * their values produce a new text per value, so past `maxStatements` texts the runs of new
+     * texts are aggregated under `otherStatements`.
+     */
+    class QueryMetrics : public IQueryObserver
+    {
+    public:
+        static constexpr std::size_t bucketCount = 24; ///< Number of latency buckets, the last one being unbounded.
+        static constexpr const char *otherStatements = "(other statements)"; ///< Key of the statements past the `maxStatements` first ones.
+
+        /**
+         * @struct Histogram
+         * @brief Latency histogram with power of two buckets, from 1µs to about 4s.
+         *
+         * Bucket `i` counts the runs that took less than `2^i` microseconds and were not counted in a previous bucket.
+         */
+        struct Histogram
+        {
+            std::array<uint64_t, bucketCount> buckets{}; /**< The number of runs per bucket. */
+
+            /**
+             * @brief Returns the upper bound of a bucket.
+             */
+            static std::chrono::microseconds upperBound(std::size_t bucket)
+            {
+                return (std::chrono::microseconds(int64_t(1) << bucket));
+            }
+
+            /**
+             * @brief Records a duration.
+             */
+            void record(std::chrono::nanoseconds duration)
+            {
+                uint64_t us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+                std::size_t bucket = 0;
+                while (bucket + 1 < bucketCount && us >= (uint64_t(1) << bucket))
+                    bucket++;
+                buckets[bucket]++;
+            }
+
+            /**
+             * @brief Estimates a percentile as the upper bound of the bucket holding it.
+             *
+             * @param percentile The percentile, between 0 and 100.
+             * @return The estimated duration, or zero if nothing was recorded.
+             */
+            std::chrono::microseconds percentile(double percentile) const
+            {
+                uint64_t total = 0;
+                for (uint64_t count : buckets)
+                    total += count;
+                if (total == 0)
+                    return (std::chrono::microseconds(0));
+
+                uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total));
+                uint64_t seen = 0;
+                for (std::size_t i = 0; i < bucketCount; i++)
+                {
+                    seen += buckets[i];
+                    if (seen > rank)
+                        return (upperBound(i));
+                }
+                return (upperBound(bucketCount - 1));
+            }
+        };
+
+        /**
+         * @struct StatementStats
+         * @brief Aggregated figures for one SQL text.
+         */
+        struct StatementStats
+        {
+            uint64_t calls = 0;                           /**< The number of runs. */
+            std::chrono::nanoseconds totalTime{0};        /**< The cumulated run time. */
+            std::chrono::nanoseconds maxTime{0};          /**< The longest run time. */
+            int64_t rowsReturned = 0;                     /**< The cumulated number of rows returned. */
+            int64_t rowsChanged = 0;                      /**< The cumulated number of rows changed. */
+            uint64_t cacheHits = 0;                       /**< The number of runs reusing a cached prepared statement. */
+            Histogram latency;                            /**< The run time distribution. */
+        };
+
+        /**
+         * @struct SlowQuery
+         * @brief An entry of the slow query log.
+         */
+        struct SlowQuery
+        {
+            std::string sql;                                 /**< The SQL text of the statement. */
+            std::chrono::nanoseconds duration;               /**< The run time. */
+            std::chrono::system_clock::time_point timestamp; /**< When the run completed. */
+        };
+
+        /**
+         * @struct Snapshot
+         * @brief A consistent copy of all the recorded figures.
+         */
+        struct Snapshot
+        {
+            uint64_t statements = 0;                                     /**< The total number of runs. */
+            int64_t rowsReturned = 0;                                    /**< The total number of rows returned. */
+            int64_t rowsChanged = 0;                                     /**< The total number of rows changed. */
+            uint64_t cacheHits = 0;                                      /**< The total number of statement cache hits. */
+            uint64_t cacheMisses = 0;                                    /**< The total number of parameterized runs that had to prepare their statement. */
+            Histogram latency;                                           /**< The run time distribution of all statements. */
+            std::unordered_map<std::string, StatementStats> perStatement; /**< The figures per SQL text, see `otherStatements`. */
+            std::vector<SlowQuery> slowQueries;                          /**< The most recent slow queries, oldest first. */
+        };
+
+        /**
+         * @brief Constructs a `QueryMetrics` observer.
+         *
+         * @param slowThreshold The run time from which a statement is logged as slow.
+         * @param slowLogSize The number of slow queries kept, older entries being dropped first.
+         * @param maxStatements The number of SQL texts with figures of their own.
+         */
+        QueryMetrics(std::chrono::nanoseconds slowThreshold = std::chrono::milliseconds(100), std::size_t slowLogSize = 128,
+                     std::size_t maxStatements = 1024)
+            : _slowThreshold(slowThreshold), _slowLogSize(slowLogSize), _maxStatements(maxStatements)
+        {
+        }
+
+        /**
+         * @brief Records a completed statement run.
+         */
+        void onQuery(const QueryEvent &event) override
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            _totals.statements++;
+            _totals.rowsReturned += event.rowsReturned;
+            _totals.rowsChanged += event.rowsChanged;
+            if (event.cacheHit)
+                _totals.cacheHits++;
+            else if (event.params)
+                _totals.cacheMisses++;
+            _totals.latency.record(event.duration);
+
+            auto found = _totals.perStatement.find(event.sql);
+            if (found == _totals.perStatement.end())
+            {
+                bool full = _totals.perStatement.size() - _totals.perStatement.count(otherStatements) >= _maxStatements;
+                found = _totals.perStatement.try_emplace(full ? std::string(otherStatements) : event.sql).first;
+            }
+            StatementStats &stats = found->second;
+            stats.calls++;
+            stats.totalTime += event.duration;
+            stats.maxTime = std::max(stats.maxTime, event.duration);
+            stats.rowsReturned += event.rowsReturned;
+            stats.rowsChanged += event.rowsChanged;
+            stats.cacheHits += event.cacheHit ? 1 : 0;
+            stats.latency.record(event.duration);
+
+            if (event.duration >= _slowThreshold)
+            {
+                _slowLog.push_back({event.sql, event.duration, std::chrono::system_clock::now()});
+                if (_slowLog.size() > _slowLogSize)
+                    _slowLog.pop_front();
+            }
+        }
+
+        /**
+         * @brief Returns a copy of all the recorded figures.
+         */
+        Snapshot snapshot() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            Snapshot snapshot = _totals;
+            snapshot.slowQueries.assign(_slowLog.begin(), _slowLog.end());
+            return (snapshot);
+        }
+
+        /**
+         * @brief Clears all the recorded figures.
+         */
+        void reset()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            _totals = Snapshot();
+            _slowLog.clear();
+        }
+
+    private:
+        mutable std::mutex _mutex;          ///< Protects the recorded figures.
+        std::chrono::nanoseconds _slowThreshold; ///< Run time from which a statement is logged as slow.
+        std::size_t _slowLogSize;           ///< Maximum number of slow query log entries.
+        std::size_t _maxStatements;         ///< Maximum number of SQL texts with figures of their own.
+        Snapshot _totals;                   ///< Recorded figures, the slow query log aside.
+        std::deque<SlowQuery> _slowLog;     ///< Most recent slow queries.
+    };
+} // namespace sqlmate
@@ -0,0 +1,102 @@
+/**
+ * @file QueryPlan.hpp
+ * @brief Defines the query plan diagnostics types in the sqlmate namespace.
+ */
+
+#include <string>
+#include <vector>
+#include <typeinfo>
+#include <functional>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @struct QueryContext
+     * @brief Describes who is running the current queries of a thread.
+     *
+     * Set by the model methods through `QueryContextScope`, it lets diagnostics point at the
+     * model type and the call site that generated a statement.
+     */
+    struct QueryContext
+    {
+        const std::type_info *model = nullptr; /**< The model type running the queries, if any. */
+        const char *file = nullptr;            /**< The source file of the call site, if known. */
+        int line = 0;                          /**< The source line of the call site, if known. */
+
+        /**
+         * @brief Returns the context of the calling thread.
+         */
+        static QueryContext &current()
+        {
+            static thread_local QueryContext context;
+            return (context);
+        }
+    };
+
+    /**
+     * @class QueryContextScope
+     * @brief Sets the query context of the calling thread for its lifetime.
+     *
+     * Can be used around raw `IDatabase::exec` calls to attribute them in diagnostics.
+     */
+    class QueryContextScope
+    {
+    public:
+        /**
+         * @brief Sets the current query context, restoring the previous one on destruction.
+         *
+         * @param model The model type running the queries.
+         * @param file The source file of the call site, or `nullptr` if unknown.
+         * @param line The source line of the call site.
+         */
+        QueryContextScope(const std::type_info &model, const char *file = nullptr, int line = 0)
+            : _previous(QueryContext::current())
+        {
+            QueryContext::current() = {&model, file, line};
+        }
+
+        ~QueryContextScope()
+        {
+            QueryContext::current() = _previous;
+        }
+
+        QueryContextScope(QueryContextScope const &) = delete;
+        void operator=(QueryContextScope const &) = delete;
+
+    private:
+        QueryContext _previous; ///< The context to restore.
+    };
+
+    /**
+     * @struct QueryPlan
+     * @brief The classified query plan of a statement.
+     */
+    struct QueryPlan
+    {
+        std::string sql;                  /**< The SQL text of the statement. */
+        std::vector<std::string> details; /**< The steps of the plan, as reported by the database. */
+        bool indexSeek = false;           /**< True if a table is searched through an index or its primary key. */
+        bool coveringIndex = false;       /**< True if an index holds every column the statement needs. */
+        bool fullScan = false;            /**< True if a table or index is scanned entirely. */
+        bool tempBTree = false;           /**< True if rows are sorted or grouped in a temporary B-tree. */
+        std::string model;                /**< The model type that first ran the statement, if known. */
+        std::string file;                 /**< The source file of the call site that first ran the statement, if known. */
+        int line = 0;                     /**< The source line of the call site that first ran the statement, if known. */
+
+        /**
+         * @brief Checks whether the plan scans or sorts rows that an index could avoid.
+         */
+        bool isOffender() const
+        {
+            return (fullScan || tempBTree);
+        }
+    };
+
+    /**
+     * @typedef plan_callback
+     * @brief Alias for a callback receiving query plans.
+     */
+    typedef std::function<void(const QueryPlan &)> plan_callback;
+} // namespace sqlmate
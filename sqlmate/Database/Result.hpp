@@ -0,0 +1,188 @@
+/**
+ * @file Result.hpp
+ * @brief Defines the non-throwing result types in the sqlmate namespace.
+ */
+
+#include <string>
+#include <variant>
+#include <utility>
+#include "../Exceptions/Database.hpp"
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @enum ErrorKind
+     * @brief Enum representing the kinds of failures, each matching an exception type.
+     */
+    enum ErrorKind
+    {
+        ERROR_NONE,      ///< No failure.
+        ERROR_DATABASE,  ///< A database failure, see `DatabaseError`.
+        ERROR_BUSY,      ///< The database is locked by another connection, see `BusyError`.
+        ERROR_TIMEOUT,   ///< The query ran past its deadline, see `QueryTimeoutError`.
+        ERROR_CANCELLED  ///< The query was cancelled, see `QueryCancelledError`.
+    };
+
+    /**
+     * @class Error
+     * @brief Describes a failure without throwing.
+     *
+     * Only holds the result code of the database and pointers to static text, so failing is
+     * as cheap as succeeding; the message is formatted when `message()` is called.
+     */
+    class Error
+    {
+    public:
+        /**
+         * @brief Constructs a success.
+         */
+        Error() : _code(0), _kind(ERROR_NONE), _description("") {}
+
+        /**
+         * @brief Constructs a failure.
+         *
+         * @param code The result code of the database, extended if available.
+         * @param kind The kind of failure.
+         * @param description A static description of the failure.
+         */
+        Error(int code, ErrorKind kind, const char *description) : _code(code), _kind(kind), _description(description) {}
+
+        /**
+         * @brief Constructs the failure matching a caught exception, whose result code is not known.
+         *
+         * @param error The caught exception.
+         * @param description A static description of the failure.
+         */
+        static Error of(const DatabaseError &error, const char *description)
+        {
+            if (dynamic_cast<const BusyError *>(&error))
+                return (Error(0, ERROR_BUSY, description));
+            if (dynamic_cast<const QueryTimeoutError *>(&error))
+                return (Error(0, ERROR_TIMEOUT, description));
+            if (dynamic_cast<const QueryCancelledError *>(&error))
+                return (Error(0, ERROR_CANCELLED, description));
+            return (Error(0, ERROR_DATABASE, description));
+        }
+
+        /**
+         * @brief Returns the result code of the database, such as `SQLITE_CONSTRAINT_UNIQUE`, or 0 on success.
+         */
+        int code() const { return _code; }
+
+        /**
+         * @brief Returns the kind of failure.
+         */
+        ErrorKind kind() const { return _kind; }
+
+        /**
+         * @brief Returns the static description of the failure.
+         */
+        const char *description() const { return _description; }
+
+        /**
+         * @brief Formats the message of the failure.
+         */
+        std::string message() const { return "[ERR]: " + std::string(_description); }
+
+        /**
+         * @brief Throws the exception matching the failure.
+         *
+         * @throw DatabaseError Or the subclass matching `kind()`.
+         */
+        [[noreturn]] void raise() const
+        {
+            switch (_kind)
+            {
+            case ERROR_BUSY:
+                throw BusyError(message());
+            case ERROR_TIMEOUT:
+                throw QueryTimeoutError(message());
+            case ERROR_CANCELLED:
+                throw QueryCancelledError(message());
+            default:
+                throw DatabaseError(message());
+            }
+        }
+
+    private:
+        int _code;                ///< The result code of the database.
+        ErrorKind _kind;          ///< The kind of failure.
+        const char *_description; ///< The static description of the failure.
+    };
+
+    /**
+     * @class Result
+     * @brief Holds either a value or the `Error` that prevented computing it, like `std::expected`.
+     *
+     * @tparam T The type of the value.
+     */
+    template <typename T>
+    class Result
+    {
+    public:
+        Result(T value) : _state(std::in_place_index<0>, std::move(value)) {}
+        Result(Error error) : _state(std::in_place_index<1>, error) {}
+
+        /**
+         * @brief Checks whether the result holds a value.
+         */
+        bool ok() const { return _state.index() == 0; }
+        explicit operator bool() const { return ok(); }
+
+        /**
+         * @brief Returns the value.
+         *
+         * @throw DatabaseError Or the subclass matching the error, if the result holds an error.
+         */
+        T &value()
+        {
+            if (!ok())
+                error().raise();
+            return std::get<0>(_state);
+        }
+
+        T &operator*() { return value(); }
+        T *operator->() { return &value(); }
+
+        /**
+         * @brief Returns the error, or a success `Error` if the result holds a value.
+         */
+        Error error() const { return ok() ? Error() : std::get<1>(_state); }
+
+    private:
+        std::variant<T, Error> _state; ///< The value or the error.
+    };
+
+    /**
+     * @class Result<void>
+     * @brief Holds the `Error` of an operation producing no value, if it failed.
+     */
+    template <>
+    class Result<void>
+    {
+    public:
+        Result() = default;
+        Result(Error error) : _error(error) {}
+
+        bool ok() const { return _error.kind() == ERROR_NONE; }
+        explicit operator bool() const { return ok(); }
+
+        /**
+         * @brief Throws the error, if any.
+         *
+         * @throw DatabaseError Or the subclass matching the error.
+         */
+        void value() const
+        {
+            if (!ok())
+                _error.raise();
+        }
+
+        Error error() const { return _error; }
+
+    private:
+        Error _error; ///< The error, a success by default.
+    };
+} // namespace sqlmate
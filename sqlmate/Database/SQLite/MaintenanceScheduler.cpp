@@ -0,0 +1,211 @@
+#include "./MaintenanceScheduler.hpp"
+#include <algorithm>
+#include <filesystem>
+
+namespace sqlmate
+{
+    MaintenanceScheduler::MaintenanceScheduler(const std::string &url, const MaintenancePolicy &policy) : _policy(policy)
+    {
+        _db.connect(url);
+
+        // Never wait for a lock held by the foreground connections
+        BusyPolicy busy;
+        busy.timeout = std::chrono::milliseconds(0);
+        busy.backoff = false;
+        busy.immediateTransactions = false;
+        _db.setBusyPolicy(busy);
+
+        std::string file;
+        RowCallBackWrapper fileOf([&](IRow &row)
+                                  {
+            if (row.getText(1) == "main")
+                file = std::string(row.getText(2));
+            return (0); });
+        _db.exec("PRAGMA database_list", {}, &fileOf);
+        if (file.empty())
+        {
+            _db.disconnect();
+            throw DatabaseError("[ERR]: maintenance requires a database stored in a file: " + url);
+        }
+        _walPath = file + "-wal";
+
+        _incrementalVacuum = _pragma("PRAGMA auto_vacuum").value_or(std::vector<int64_t>{0})[0] == 2;
+        _pragma("PRAGMA analysis_limit = " + std::to_string(_policy.analysisLimit));
+        _dataVersion = _pragma("PRAGMA data_version").value_or(std::vector<int64_t>{-1})[0];
+        _lastCommit = std::chrono::steady_clock::now();
+        _lastOptimize = _lastCommit - _policy.optimizeEvery;
+
+        _thread = std::thread(&MaintenanceScheduler::_loop, this);
+    }
+
+    MaintenanceScheduler::~MaintenanceScheduler()
+    {
+        stop();
+        _db.disconnect();
+    }
+
+    void MaintenanceScheduler::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    bool MaintenanceScheduler::runOnce()
+    {
+        std::lock_guard<std::mutex> lock(_stepMutex);
+        auto now = std::chrono::steady_clock::now();
+
+        auto version = _pragma("PRAGMA data_version");
+        if (!version)
+        {
+            _skip();
+            return (false);
+        }
+        if ((*version)[0] != _dataVersion)
+        {
+            _dataVersion = (*version)[0];
+            _lastCommit = now;
+        }
+        bool idle = now - _lastCommit >= _policy.idleAfter;
+
+        int64_t wal = _walSize();
+        if (_policy.truncateBytes > 0 && wal > _policy.truncateBytes && idle && _checkpoint("TRUNCATE"))
+            return (true);
+        if (_policy.checkpointBytes > 0 && wal > _policy.checkpointBytes && _dataVersion != _checkpointVersion)
+            return (_checkpoint("PASSIVE"));
+        if (_vacuum())
+            return (true);
+        if (idle && _policy.optimizeEvery.count() > 0 && _dataVersion != _optimizeVersion && now - _lastOptimize >= _policy.optimizeEvery)
+            return (_optimize());
+        return (false);
+    }
+
+    MaintenanceStats MaintenanceScheduler::stats()
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        return (_stats);
+    }
+
+    void MaintenanceScheduler::_loop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_wake.wait_for(lock, _policy.interval, [this]
+                               { return (_stopping); }))
+        {
+            lock.unlock();
+            try
+            {
+                runOnce();
+            }
+            catch (const DatabaseError &)
+            {
+                std::lock_guard<std::mutex> statsLock(_statsMutex);
+                _stats.failures++;
+            }
+            lock.lock();
+        }
+    }
+
+    std::optional<std::vector<int64_t>> MaintenanceScheduler::_pragma(const std::string &query)
+    {
+        std::vector<int64_t> values;
+        bool first = true;
+        RowCallBackWrapper collect([&](IRow &row)
+                                   {
+            if (first)
+                for (int col = 0; col < row.columnCount(); col++)
+                    values.push_back(row.getInt64(col));
+            first = false;
+            return (0); });
+
+        Result<void> result = _db.tryExec(query, {}, &collect);
+        if (!result)
+        {
+            if (result.error().kind() == ERROR_BUSY)
+                return (std::nullopt);
+            result.error().raise();
+        }
+        return (values);
+    }
+
+    int64_t MaintenanceScheduler::_walSize() const
+    {
+        std::error_code error;
+        auto size = std::filesystem::file_size(_walPath, error);
+        return (error ? 0 : static_cast<int64_t>(size));
+    }
+
+    bool MaintenanceScheduler::_checkpoint(const char *mode)
+    {
+        auto result = _pragma(std::string("PRAGMA wal_checkpoint(") + mode + ")");
+        // The row holds whether the checkpoint was blocked, the frames of the WAL and the frames copied
+        if (!result || result->size() < 3 || (*result)[0] != 0)
+        {
+            _skip();
+            return (false);
+        }
+        if ((*result)[1] == (*result)[2])
+            _checkpointVersion = _dataVersion;
+
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        if (std::string(mode) == "TRUNCATE")
+            _stats.truncations++;
+        else
+            _stats.checkpoints++;
+        _stats.framesCheckpointed += std::max<int64_t>((*result)[2], 0);
+        return (true);
+    }
+
+    bool MaintenanceScheduler::_vacuum()
+    {
+        if (!_incrementalVacuum || _policy.vacuumPages <= 0)
+            return (false);
+
+        auto before = _pragma("PRAGMA freelist_count");
+        if (before && (before->empty() || (*before)[0] <= _policy.vacuumThreshold))
+            return (false);
+        if (!before || !_pragma("PRAGMA incremental_vacuum(" + std::to_string(_policy.vacuumPages) + ")"))
+        {
+            _skip();
+            return (false);
+        }
+        auto after = _pragma("PRAGMA freelist_count");
+
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        _stats.vacuumSteps++;
+        if (after && !after->empty())
+            _stats.pagesVacuumed += (*before)[0] - (*after)[0];
+        return (true);
+    }
+
+    bool MaintenanceScheduler::_optimize()
+    {
+        // Before 3.46, `PRAGMA optimize` only considers the tables used by its own connection
+        const char *query = sqlite3_libversion_number() >= 3046000 ? "PRAGMA optimize(0x10002)" : "ANALYZE";
+        Result<void> result = _db.tryExec(query, nullptr);
+        if (!result)
+        {
+            if (result.error().kind() != ERROR_BUSY)
+                result.error().raise();
+            _skip();
+            return (false);
+        }
+        _optimizeVersion = _dataVersion;
+        _lastOptimize = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        _stats.optimizations++;
+        return (true);
+    }
+
+    void MaintenanceScheduler::_skip()
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        _stats.skipped++;
+    }
+} // namespace sqlmate
@@ -0,0 +1,175 @@
+/**
+ * @file MaintenanceScheduler.hpp
+ * @brief Background maintenance of an SQLite database file.
+ */
+
+#include "./SQLite.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @struct MaintenancePolicy
+     * @brief Describes when the maintenance steps of a `MaintenanceScheduler` run.
+     */
+    struct MaintenancePolicy
+    {
+        std::chrono::milliseconds interval{1000};         /**< Time between two wake-ups, each running at most one step. */
+        std::chrono::milliseconds idleAfter{5000};        /**< Time without commits after which the database is idle. */
+        int64_t checkpointBytes = 4 * 1024 * 1024;        /**< WAL file size above which passive checkpoints run, 0 to disable them. */
+        int64_t truncateBytes = 64 * 1024 * 1024;         /**< WAL file size above which an idle database is truncated, 0 to disable it. */
+        int vacuumPages = 128;                            /**< Pages released by each incremental vacuum step, 0 to disable them. */
+        int64_t vacuumThreshold = 256;                    /**< Free pages above which incremental vacuum steps run. */
+        std::chrono::minutes optimizeEvery{60};           /**< Minimum time between two statistics updates, 0 to disable them. */
+        int analysisLimit = 400;                          /**< Rows examined per index by the statistics updates, see `PRAGMA analysis_limit`. */
+    };
+
+    /**
+     * @struct MaintenanceStats
+     * @brief Counters of the maintenance steps run by a `MaintenanceScheduler`.
+     */
+    struct MaintenanceStats
+    {
+        int64_t checkpoints = 0;        /**< Passive checkpoints run. */
+        int64_t truncations = 0;        /**< Truncating checkpoints run. */
+        int64_t framesCheckpointed = 0; /**< WAL frames copied back to the database file by the checkpoints. */
+        int64_t vacuumSteps = 0;        /**< Incremental vacuum steps run. */
+        int64_t pagesVacuumed = 0;      /**< Pages released by the incremental vacuum steps. */
+        int64_t optimizations = 0;      /**< Statistics updates run. */
+        int64_t skipped = 0;            /**< Steps given up because the database was busy. */
+        int64_t failures = 0;           /**< Steps of the thread that failed for another reason. */
+    };
+
+    /**
+     * @class MaintenanceScheduler
+     * @brief A thread keeping an SQLite database file in shape while the application uses it.
+     *
+     * The scheduler opens a connection of its own to the file and wakes up every
+     * `MaintenancePolicy::interval` to run at most one maintenance step, in this order of priority:
+     *
+     * - a `TRUNCATE` WAL checkpoint, resetting the `-wal` file once it outgrew
+     *   `MaintenancePolicy::truncateBytes`, when the database is idle;
+     * - a `PASSIVE` WAL checkpoint when the `-wal` file holds more than
+     *   `MaintenancePolicy::checkpointBytes` and was written to since the last one;
+     * - an `incremental_vacuum` step of `MaintenancePolicy::vacuumPages` pages, when the database
+     *   uses `auto_vacuum = INCREMENTAL` and has more free pages than `MaintenancePolicy::vacuumThreshold`;
+     * - an `ANALYZE` pass, bounded by `MaintenancePolicy::analysisLimit`, when the database is idle
+     *   and was written to since the last one, at most every `MaintenancePolicy::optimizeEvery`.
+     *
+     * The database is idle when no other connection committed for `MaintenancePolicy::idleAfter`,
+     * as told by `PRAGMA data_version`. The connection of the scheduler never waits for a lock: a
+     * step finding the database busy is skipped until the next wake-up, so foreground queries are
+     * never stalled by more than the length of a single step.
+     *
+     * Foreground connections may disable their own checkpoints with `PRAGMA wal_autocheckpoint = 0`
+     * to keep them off the commit path.
+     */
+    class MaintenanceScheduler
+    {
+    public:
+        /**
+         * @brief Opens a connection to a database file and starts the maintenance thread.
+         *
+         * @param url The path or URI filename of the database, as given to `SQLite::connect()`.
+         * @param policy When the maintenance steps run.
+         * @throw DatabaseError If the connection fails or the database is not stored in a file.
+         */
+        MaintenanceScheduler(const std::string &url, const MaintenancePolicy &policy = MaintenancePolicy());
+
+        /**
+         * @brief Stops the maintenance thread and closes its connection.
+         */
+        ~MaintenanceScheduler();
+
+        MaintenanceScheduler(const MaintenanceScheduler &) = delete;
+        MaintenanceScheduler &operator=(const MaintenanceScheduler &) = delete;
+
+        /**
+         * @brief Stops the maintenance thread, letting a running step finish.
+         */
+        void stop();
+
+        /**
+         * @brief Runs one maintenance step on the calling thread, as if the thread woke up.
+         *
+         * @return True if a step ran, false if there was nothing to do or the database was busy.
+         */
+        bool runOnce();
+
+        /**
+         * @brief Returns the counters of the maintenance steps run so far.
+         */
+        MaintenanceStats stats();
+
+    private:
+        MaintenancePolicy _policy;                                        ///< When the maintenance steps run.
+        SQLite _db;                                               ///< The connection of the scheduler.
+        std::string _walPath;                                     ///< The path of the `-wal` file.
+        bool _incrementalVacuum = false;                          ///< Whether the database uses `auto_vacuum = INCREMENTAL`.
+        int64_t _dataVersion = -1;                                ///< The last `PRAGMA data_version` read.
+        int64_t _checkpointVersion = -1;                          ///< The data version at the last complete checkpoint.
+        int64_t _optimizeVersion = -1;                            ///< The data version at the last statistics update.
+        std::chrono::steady_clock::time_point _lastCommit;        ///< When a commit of another connection was last seen.
+        std::chrono::steady_clock::time_point _lastOptimize;      ///< When the statistics were last updated.
+        std::mutex _stepMutex;                                    ///< Serializes the steps and protects the state above.
+        std::mutex _statsMutex;                                   ///< Protects the counters.
+        MaintenanceStats _stats;                                          ///< The counters of the steps.
+        std::mutex _mutex;                                        ///< Protects the stop flag.
+        std::condition_variable _wake;                            ///< Signaled when the thread must stop.
+        bool _stopping = false;                                   ///< Whether the thread must exit.
+        std::thread _thread;                                      ///< The maintenance thread.
+
+        /**
+         * @brief Runs the steps every `MaintenancePolicy::interval` until stopped.
+         */
+        void _loop();
+
+        /**
+         * @brief Runs a pragma returning integers, without waiting for locks.
+         *
+         * @return The columns of the first result row, if any, or nothing if the database was busy.
+         * @throw DatabaseError If the pragma fails for another reason.
+         */
+        std::optional<std::vector<int64_t>> _pragma(const std::string &query);
+
+        /**
+         * @brief Returns the size of the `-wal` file, 0 if there is none.
+         */
+        int64_t _walSize() const;
+
+        /**
+         * @brief Runs a WAL checkpoint of a mode.
+         *
+         * @return True if the checkpoint ran, false if the database was busy.
+         */
+        bool _checkpoint(const char *mode);
+
+        /**
+         * @brief Runs an incremental vacuum step if enough pages are free.
+         *
+         * @return True if a step ran.
+         */
+        bool _vacuum();
+
+        /**
+         * @brief Updates the statistics of the query planner.
+         *
+         * @return True if the update ran.
+         */
+        bool _optimize();
+
+        /**
+         * @brief Counts a step given up because the database was busy.
+         */
+        void _skip();
+    };
+} // namespace sqlmate
@@ -0,0 +1,187 @@
+#include "./PoolAllocator.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace sqlmate
+{
+    namespace
+    {
+        constexpr int headerSize = 8;                  ///< Size of the header prepended to every block, keeping 8-byte alignment.
+        constexpr std::size_t arenaSize = 256 * 1024;  ///< Size of the arenas carved into blocks.
+        constexpr int classCount = 36;                 ///< 16-byte steps up to 512 bytes, then powers of two up to 8 KiB.
+
+        /**
+         * @brief Returns the block size of a size class, header included.
+         */
+        constexpr int classSize(int cls)
+        {
+            return (cls < 32 ? (cls + 1) * 16 : 512 << (cls - 31));
+        }
+
+        /**
+         * @brief Returns the smallest size class holding a block of `total` bytes, or -1 if none does.
+         */
+        int classFor(int total)
+        {
+            if (total <= 512)
+                return ((total + 15) / 16 - 1);
+            for (int cls = 32; cls < classCount; cls++)
+                if (total <= classSize(cls))
+                    return (cls);
+            return (-1);
+        }
+
+        /**
+         * @brief The state of the pool, shared by the whole process.
+         */
+        struct Pool
+        {
+            std::mutex mutex;
+            void *freeLists[classCount] = {};
+            char *cursor = nullptr;
+            std::size_t left = 0;
+            PoolAllocator::Stats stats;
+        };
+
+        /**
+         * @brief Returns the pool, never destroyed since SQLite may free memory during static destruction.
+         */
+        Pool &pool()
+        {
+            static Pool *instance = new Pool();
+            return (*instance);
+        }
+
+        // A block header holds its size class, or minus its usable size for allocations served by malloc
+        int64_t &header(void *p)
+        {
+            return (*reinterpret_cast<int64_t *>(static_cast<char *>(p) - headerSize));
+        }
+
+        int poolSize(void *p)
+        {
+            int64_t h = header(p);
+            return (h < 0 ? static_cast<int>(-h) : classSize(static_cast<int>(h)) - headerSize);
+        }
+
+        void *poolMalloc(int n)
+        {
+            int total = (n > 0 ? n : 1) + headerSize;
+            int cls = classFor(total);
+            char *block;
+
+            if (cls < 0)
+            {
+                total = (total + 7) & ~7;
+                block = static_cast<char *>(std::malloc(total));
+                if (block == nullptr)
+                    return (nullptr);
+                *reinterpret_cast<int64_t *>(block) = -(total - headerSize);
+
+                std::lock_guard<std::mutex> lock(pool().mutex);
+                pool().stats.largeBytes += total;
+                pool().stats.largeBlocks++;
+                return (block + headerSize);
+            }
+
+            Pool &p = pool();
+            std::lock_guard<std::mutex> lock(p.mutex);
+            if (p.freeLists[cls])
+            {
+                block = static_cast<char *>(p.freeLists[cls]);
+                p.freeLists[cls] = *reinterpret_cast<void **>(block + headerSize);
+            }
+            else
+            {
+                std::size_t size = static_cast<std::size_t>(classSize(cls));
+                if (p.left < size)
+                {
+                    p.cursor = static_cast<char *>(std::malloc(arenaSize));
+                    if (p.cursor == nullptr)
+                    {
+                        p.left = 0;
+                        return (nullptr);
+                    }
+                    p.left = arenaSize;
+                    p.stats.arenaBytes += arenaSize;
+                }
+                block = p.cursor;
+                p.cursor += size;
+                p.left -= size;
+            }
+            *reinterpret_cast<int64_t *>(block) = cls;
+            p.stats.pooledBytes += classSize(cls);
+            p.stats.pooledBlocks++;
+            return (block + headerSize);
+        }
+
+        void poolFree(void *ptr)
+        {
+            if (ptr == nullptr)
+                return;
+
+            int64_t h = header(ptr);
+            char *block = static_cast<char *>(ptr) - headerSize;
+            Pool &p = pool();
+            std::lock_guard<std::mutex> lock(p.mutex);
+
+            if (h < 0)
+            {
+                p.stats.largeBytes -= -h + headerSize;
+                p.stats.largeBlocks--;
+                std::free(block);
+                return;
+            }
+            *reinterpret_cast<void **>(ptr) = p.freeLists[h];
+            p.freeLists[h] = block;
+            p.stats.pooledBytes -= classSize(static_cast<int>(h));
+            p.stats.pooledBlocks--;
+        }
+
+        void *poolRealloc(void *ptr, int n)
+        {
+            if (n <= poolSize(ptr))
+                return (ptr);
+
+            void *resized = poolMalloc(n);
+            if (resized == nullptr)
+                return (nullptr);
+            std::memcpy(resized, ptr, poolSize(ptr));
+            poolFree(ptr);
+            return (resized);
+        }
+
+        int poolRoundup(int n)
+        {
+            int total = (n > 0 ? n : 1) + headerSize;
+            int cls = classFor(total);
+            return (cls < 0 ? ((total + 7) & ~7) - headerSize : classSize(cls) - headerSize);
+        }
+
+        int poolInit(void *) { return (SQLITE_OK); }
+
+        void poolShutdown(void *) {}
+    }
+
+    const sqlite3_mem_methods &PoolAllocator::methods()
+    {
+        static const sqlite3_mem_methods methods = {
+            poolMalloc,
+            poolFree,
+            poolRealloc,
+            poolSize,
+            poolRoundup,
+            poolInit,
+            poolShutdown,
+            nullptr};
+        return (methods);
+    }
+
+    PoolAllocator::Stats PoolAllocator::stats()
+    {
+        std::lock_guard<std::mutex> lock(pool().mutex);
+        return (pool().stats);
+    }
+}
@@ -0,0 +1,50 @@
+/**
+ * @file PoolAllocator.hpp
+ * @brief Size-class pool allocator for the SQLite3 C library.
+ */
+
+#include <cstdint>
+#include <sqlite3.h>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @class PoolAllocator
+     * @brief Process-wide size-class pool allocator for SQLite.
+     *
+     * Small allocations are rounded up to one of a few size classes and served from free lists
+     * refilled by carving large arenas, which are never returned to the system. Long-running
+     * processes thus reuse the same blocks instead of fragmenting the heap with the many short-lived
+     * allocations of SQLite. Allocations larger than the biggest class go to `malloc`.
+     *
+     * Install it with `SQLite::installAllocator(PoolAllocator::methods())` before opening any connection.
+     */
+    class PoolAllocator
+    {
+    public:
+        /**
+         * @struct Stats
+         * @brief Usage figures of the pool.
+         */
+        struct Stats
+        {
+            int64_t arenaBytes = 0;       /**< Bytes reserved in arenas. */
+            int64_t pooledBytes = 0;      /**< Bytes of arena blocks in use, headers included. */
+            int64_t pooledBlocks = 0;     /**< Number of arena blocks in use. */
+            int64_t largeBytes = 0;       /**< Bytes of allocations served by `malloc`, headers included. */
+            int64_t largeBlocks = 0;      /**< Number of allocations served by `malloc`. */
+        };
+
+        /**
+         * @brief Returns the SQLite memory methods backed by the pool.
+         */
+        static const sqlite3_mem_methods &methods();
+
+        /**
+         * @brief Returns the usage figures of the pool.
+         */
+        static Stats stats();
+    };
+} // namespace sqlmate
@@ -1,8 +1,58 @@
 #include "./SQLite.hpp"
+#include <cxxabi.h>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <optional>
+#include <random>
+#include <thread>
 
 namespace sqlmate
 {
-    SQLite::SQLite() : _connected(false)
+    namespace
+    {
+        /**
+         * @brief Binds a value to a statement parameter with the matching `sqlite3_bind_*` call.
+         * 
+         * Values are bound as `SQLITE_STATIC`: they are owned by the caller and outlive the execution.
+         */
+        template <typename T>
+        int bindValue(sqlite3_stmt *stmt, int index, const T &value)
+        {
+            if constexpr (is_optional<T>::value)
+                return (value ? bindValue(stmt, index, *value) : sqlite3_bind_null(stmt, index));
+            else if constexpr (std::is_same<T, BlobStream>::value)
+                return (value.reserved() ? sqlite3_bind_zeroblob64(stmt, index, *value.reserved())
+                                         : sqlite3_bind_null(stmt, index));
+            else if constexpr (std::is_same<T, std::string>::value)
+                return (sqlite3_bind_text64(stmt, index, value.data(), value.size(), SQLITE_STATIC, SQLITE_UTF8));
+            else if constexpr (std::is_same<T, std::vector<std::byte>>::value)
+                return (value.empty() ? sqlite3_bind_zeroblob(stmt, index, 0)
+                                      : sqlite3_bind_blob64(stmt, index, value.data(), value.size(), SQLITE_STATIC));
+            else if constexpr (std::is_floating_point<T>::value)
+                return (sqlite3_bind_double(stmt, index, value));
+            else
+                return (sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(value)));
+        }
+
+        /**
+         * @brief Resets a cached statement when leaving scope, even if a row callback throws.
+         */
+        struct StatementGuard
+        {
+            sqlite3_stmt *stmt;
+
+            ~StatementGuard()
+            {
+                sqlite3_reset(stmt);
+                sqlite3_clear_bindings(stmt);
+            }
+        };
+    }
+
+    SQLite::SQLite() : _connected(false), _db(nullptr)
     {
         qbuilder = std::make_shared<QueryBuilder>();
     }
@@ -10,58 +60,997 @@ namespace sqlmate
     void SQLite::connect(std::string url)
     {
         // std::cout << "Connecting to " << url << std::endl;
-        int rc = sqlite3_open(
+        // The cached statements and plans belong to the previous handle
+        if (_connected)
+            disconnect();
+        int rc = sqlite3_open_v2(
             url.c_str(),
-            &_db);
+            &_db,
+            SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI,
+            nullptr);
 
         if (rc != SQLITE_OK)
             throw DatabaseError("[ERROR]: Unable to connect to database: " + url);
 
         _connected = true;
+        _installBusyHandler();
+        _installTrace();
+        _installHooks();
     }
     bool SQLite::isConnected() { return _connected; }
 
     void SQLite::disconnect()
     {
         // std::cout << "Disconnecting" << std::endl;
+        for (auto &[query, cached] : _statements)
+            sqlite3_finalize(cached.stmt);
+        _statements.clear();
+        _statementUses.clear();
+        _explained.clear();
+        _pendingChanges.clear();
+        _committedChanges.clear();
         sqlite3_close(_db);
+        _db = nullptr;
         _connected = false;
     }
 
     void SQLite::exec(std::string query, QueryCallBackWrapper *cb_wrapper)
     {
+        int rc = _execRaw(query, cb_wrapper);
+        if (rc != SQLITE_OK)
+            _fail(rc);
+    }
+
+    void SQLite::exec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper)
+    {
+        int rc = _run(query, &params, nullptr, cb_wrapper);
+        if (rc != SQLITE_OK)
+            _fail(rc);
+    }
+
+    void SQLite::exec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper)
+    {
+        int rc = _run(query, nullptr, &binder.get(), cb_wrapper);
+        if (rc != SQLITE_OK)
+            _fail(rc);
+    }
+
+    Result<void> SQLite::tryExec(const std::string &query, QueryCallBackWrapper *cb_wrapper)
+    {
+        int rc = _execRaw(query, cb_wrapper);
+        return (rc == SQLITE_OK ? Result<void>() : Result<void>(_error(rc)));
+    }
+
+    Result<void> SQLite::tryExec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper)
+    {
+        int rc = _run(query, &params, nullptr, cb_wrapper);
+        return (rc == SQLITE_OK ? Result<void>() : Result<void>(_error(rc)));
+    }
+
+    Result<void> SQLite::tryExec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper)
+    {
+        int rc = _run(query, nullptr, &binder.get(), cb_wrapper);
+        return (rc == SQLITE_OK ? Result<void>() : Result<void>(_error(rc)));
+    }
+
+    int SQLite::_execRaw(const std::string &query, QueryCallBackWrapper *cb_wrapper)
+    {
+        const std::string &sql = _transactionMode(query);
         int rc;
 
-        if (cb_wrapper == nullptr)
+        _failure = nullptr;
+        if ((rc = _armDeadline()) != SQLITE_OK)
+            return (rc);
+        _currentParams = nullptr;
+        _cacheHit = false;
+
+        // Statements run one by one, as sqlite3_exec would, to know which one failed
+        std::size_t pending = _pendingChanges.size();
+        const char *next = sql.c_str();
+        rc = SQLITE_OK;
+        while (rc == SQLITE_OK && next && *next)
         {
-            rc = sqlite3_exec(
-                _db,
-                query.c_str(),
-                NULL,
-                0,
-                NULL);
+            sqlite3_stmt *stmt = nullptr;
+            pending = _pendingChanges.size();
+            if ((rc = sqlite3_prepare_v2(_db, next, -1, &stmt, &next)) != SQLITE_OK || stmt == nullptr)
+                continue;
+
+            std::vector<char *> values;
+            std::vector<char *> names;
+            try
+            {
+                while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+                {
+                    if (cb_wrapper == nullptr)
+                        continue;
+                    int count = sqlite3_column_count(stmt);
+                    values.resize(count);
+                    names.resize(count);
+                    for (int i = 0; i < count; i++)
+                    {
+                        values[i] = const_cast<char *>(reinterpret_cast<const char *>(sqlite3_column_text(stmt, i)));
+                        names[i] = const_cast<char *>(sqlite3_column_name(stmt, i));
+                    }
+                    if (cb_wrapper->get()(count, values.data(), names.data()) != 0)
+                    {
+                        _failure = "query aborted";
+                        rc = SQLITE_ABORT;
+                        break;
+                    }
+                }
+            }
+            catch (...)
+            {
+                // Finalizing stops the statement without rolling it back, its changes stay pending
+                sqlite3_finalize(stmt);
+                _settleChanges(false);
+                throw;
+            }
+            sqlite3_finalize(stmt);
+            if (rc == SQLITE_DONE)
+                rc = SQLITE_OK;
         }
-        else
+
+        if (rc != SQLITE_OK)
         {
-            rc = sqlite3_exec(
-                _db,
-                query.c_str(),
-                [](void *data, int argc, char **argv, char **azColName) -> int
+            _discardFailedChanges(pending);
+            _settleChanges(false);
+            return (rc);
+        }
+        if (_planReporter)
+            _analyze(query);
+        _settleChanges(true);
+        return (SQLITE_OK);
+    }
+
+    int SQLite::_run(const std::string &query, const std::vector<FieldInfo> *params, const bind_callback *binder, RowCallBackWrapper *cb_wrapper)
+    {
+        int rc;
+
+        _failure = nullptr;
+        if ((rc = _armDeadline()) != SQLITE_OK)
+            return (rc);
+        std::size_t pending = _pendingChanges.size();
+        try
+        {
+            sqlite3_stmt *stmt = nullptr;
+            rc = _prepare(_transactionMode(query), stmt);
+            if (rc == SQLITE_OK)
+            {
+                _currentParams = params;
+                StatementGuard guard{stmt};
+
+                if (params)
+                    for (std::size_t i = 0; i < params->size() && rc == SQLITE_OK; i++)
+                        rc = _bind(stmt, static_cast<int>(i + 1), (*params)[i]);
+                if (binder && *binder && rc == SQLITE_OK)
                 {
-                    QueryCallBackWrapper *wrapper = static_cast<QueryCallBackWrapper *>(data);
-                    return (wrapper->get()(argc, argv, azColName));
-                },
-                cb_wrapper,
-                NULL);
+                    Params bound(stmt);
+                    (*binder)(bound);
+                    rc = bound.status();
+                }
+
+                if (rc == SQLITE_OK)
+                {
+                    row_callback cb = cb_wrapper ? cb_wrapper->get() : nullptr;
+                    Row row(stmt);
+                    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+                    {
+                        if (cb && cb(row) != 0)
+                        {
+                            _failure = "query aborted";
+                            rc = SQLITE_ABORT;
+                            break;
+                        }
+                    }
+                    if (rc == SQLITE_DONE)
+                        rc = SQLITE_OK;
+                }
+            }
+        }
+        catch (...)
+        {
+            // Exceptions come from the binder or the row callback: the reset statement is not rolled back
+            _settleChanges(false);
+            throw;
+        }
+        if (rc != SQLITE_OK)
+        {
+            _discardFailedChanges(pending);
+            _settleChanges(false);
+            return (rc);
+        }
+        if (_planReporter)
+            _analyze(query);
+        _settleChanges(true);
+        return (SQLITE_OK);
+    }
+
+    int64_t SQLite::changes()
+    {
+        return (sqlite3_changes64(_db));
+    }
+
+    std::shared_ptr<IBlob> SQLite::openBlob(const std::string &table, const std::string &column, int64_t rowid, bool writable)
+    {
+        sqlite3_blob *blob = nullptr;
+        int rc = sqlite3_blob_open(_db, "main", table.c_str(), column.c_str(), rowid, writable ? 1 : 0, &blob);
+
+        if (rc != SQLITE_OK)
+        {
+            std::string message = sqlite3_errmsg(_db);
+            sqlite3_blob_close(blob);
+            throw DatabaseError("[ERR]: " + message);
         }
+        return (std::make_shared<Blob>(_db, blob));
+    }
 
+    int SQLite::_prepare(const std::string &query, sqlite3_stmt *&stmt)
+    {
+        auto cached = _statements.find(query);
+        _cacheHit = cached != _statements.end();
+        if (_cacheHit)
+        {
+            _statementUses.splice(_statementUses.begin(), _statementUses, cached->second.use);
+            stmt = cached->second.stmt;
+            return (SQLITE_OK);
+        }
+
+        int rc = sqlite3_prepare_v3(_db, query.c_str(), static_cast<int>(query.size() + 1),
+                                    SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
         if (rc != SQLITE_OK)
+            return (rc);
+        if (stmt == nullptr)
+        {
+            _failure = "empty query";
+            return (SQLITE_MISUSE);
+        }
+
+        // Statements still stepping, such as the outer query of a nested one, are kept
+        for (auto use = _statementUses.end(); _statements.size() >= _statementCacheSize && use != _statementUses.begin();)
+        {
+            auto evicted = _statements.find(**--use);
+            if (sqlite3_stmt_busy(evicted->second.stmt))
+                continue;
+            sqlite3_finalize(evicted->second.stmt);
+            use = _statementUses.erase(use);
+            _statements.erase(evicted);
+        }
+        auto inserted = _statements.insert({query, {stmt, {}}}).first;
+        _statementUses.push_front(&inserted->first);
+        inserted->second.use = _statementUses.begin();
+        return (SQLITE_OK);
+    }
+
+    int SQLite::_bind(sqlite3_stmt *stmt, int index, const FieldInfo &field)
+    {
+        int rc = SQLITE_OK;
+
+        if (!visitField(field, [&](auto &value)
+                        { rc = bindValue(stmt, index, value); }))
+        {
+            _failure = "Unsupported type for binding";
+            return (SQLITE_MISUSE);
+        }
+        return (rc);
+    }
+
+    void SQLite::setObserver(std::shared_ptr<IQueryObserver> observer)
+    {
+        _observer = observer;
+        if (_connected)
+            _installTrace();
+    }
+
+    void SQLite::_installTrace()
+    {
+        if (_observer)
+            sqlite3_trace_v2(_db, SQLITE_TRACE_STMT | SQLITE_TRACE_ROW | SQLITE_TRACE_PROFILE, &SQLite::_trace, this);
+        else
+            sqlite3_trace_v2(_db, 0, nullptr, nullptr);
+    }
+
+    int SQLite::_trace(unsigned type, void *ctx, void *p, void *x)
+    {
+        SQLite *self = static_cast<SQLite *>(ctx);
+        sqlite3_stmt *stmt = static_cast<sqlite3_stmt *>(p);
+
+        switch (type)
+        {
+        case SQLITE_TRACE_STMT:
+            // Statements run by triggers are reported with a "--" comment, count them in their caller
+            if (std::string_view(static_cast<const char *>(x)).substr(0, 2) != "--")
+            {
+                self->_traceStart = std::chrono::steady_clock::now();
+                self->_traceRows = 0;
+                self->_traceChanges = sqlite3_total_changes64(self->_db);
+            }
+            break;
+        case SQLITE_TRACE_ROW:
+            self->_traceRows++;
+            break;
+        case SQLITE_TRACE_PROFILE:
+            if (self->_observer && !sqlite3_stmt_isexplain(stmt))
+            {
+                char *expanded = nullptr;
+                if (!self->_currentParams && sqlite3_bind_parameter_count(stmt) && self->_observer->wantsExpandedSql())
+                    expanded = sqlite3_expanded_sql(stmt);
+                QueryEvent event{sqlite3_sql(stmt),
+                                 self->_currentParams,
+                                 std::chrono::steady_clock::now() - self->_traceStart,
+                                 self->_traceRows,
+                                 sqlite3_total_changes64(self->_db) - self->_traceChanges,
+                                 self->_cacheHit,
+                                 expanded};
+                self->_observer->onQuery(event);
+                sqlite3_free(expanded);
+            }
+            break;
+        }
+        return (0);
+    }
+
+    void SQLite::setPlanAnalyzer(plan_callback reporter, bool offendersOnly)
+    {
+        _planReporter = reporter;
+        _planOffendersOnly = offendersOnly;
+        _explained.clear();
+    }
+
+    void SQLite::_analyze(const std::string &query)
+    {
+        // Queries inlining their values are new texts on every run, forget them rather than grow without bound
+        if (_explained.size() >= _explainedLimit)
+            _explained.clear();
+        if (!_explained.insert(query).second)
+            return;
+
+        const char *next = query.c_str();
+
+        while (next && *next)
+        {
+            sqlite3_stmt *stmt = nullptr;
+            if (sqlite3_prepare_v2(_db, next, -1, &stmt, &next) != SQLITE_OK)
+                return;
+            if (stmt == nullptr)
+                continue;
+
+            std::string sql = sqlite3_sql(stmt);
+            sqlite3_finalize(stmt);
+            if (sql != query && !_explained.insert(sql).second)
+                continue;
+
+            QueryPlan plan;
+            if (!_explain(sql, plan) || (_planOffendersOnly && !plan.isOffender()))
+                continue;
+
+            const QueryContext &context = QueryContext::current();
+            if (context.model)
+            {
+                char *name = abi::__cxa_demangle(context.model->name(), nullptr, nullptr, nullptr);
+                plan.model = name ? name : context.model->name();
+                std::free(name);
+            }
+            plan.file = context.file ? context.file : "";
+            plan.line = context.line;
+            _planReporter(plan);
+        }
+    }
+
+    bool SQLite::_explain(const std::string &sql, QueryPlan &plan)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        std::string query = "EXPLAIN QUERY PLAN " + sql;
+
+        if (sqlite3_prepare_v2(_db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            sqlite3_finalize(stmt);
+            return (false);
+        }
+
+        plan.sql = sql;
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+            std::string detail = text ? text : "";
+
+            if (detail.rfind("SEARCH ", 0) == 0)
+                plan.indexSeek = true;
+            else if (detail.rfind("SCAN ", 0) == 0 && detail.find("CONSTANT ROW") == std::string::npos &&
+                     detail.find("VIRTUAL TABLE") == std::string::npos)
+                plan.fullScan = true;
+            if (detail.find("COVERING INDEX") != std::string::npos)
+                plan.coveringIndex = true;
+            if (detail.rfind("USE TEMP B-TREE", 0) == 0)
+                plan.tempBTree = true;
+            plan.details.push_back(detail);
+        }
+        sqlite3_finalize(stmt);
+        return (true);
+    }
+
+    void SQLite::snapshotTo(const std::string &path, int pagesPerStep)
+    {
+        std::string tmpPath = path + ".tmp";
+        sqlite3 *destination = nullptr;
+
+        std::remove(tmpPath.c_str());
+        if (sqlite3_open(tmpPath.c_str(), &destination) != SQLITE_OK)
+        {
+            sqlite3_close(destination);
+            throw DatabaseError("[ERR]: Unable to open snapshot file: " + tmpPath);
+        }
+        try
+        {
+            _backup(destination, _db, pagesPerStep);
+        }
+        catch (const DatabaseError &)
+        {
+            sqlite3_close(destination);
+            std::remove(tmpPath.c_str());
+            throw;
+        }
+        sqlite3_close(destination);
+
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+            throw DatabaseError("[ERR]: Unable to replace snapshot file: " + path);
+    }
+
+    void SQLite::restoreFrom(const std::string &path, int pagesPerStep)
+    {
+        sqlite3 *source = nullptr;
+
+        if (sqlite3_open_v2(path.c_str(), &source, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+        {
+            sqlite3_close(source);
+            throw DatabaseError("[ERR]: Unable to open snapshot file: " + path);
+        }
+        try
+        {
+            _backup(_db, source, pagesPerStep);
+        }
+        catch (const DatabaseError &)
+        {
+            sqlite3_close(source);
+            throw;
+        }
+        sqlite3_close(source);
+    }
+
+    void SQLite::_backup(sqlite3 *destination, sqlite3 *source, int pagesPerStep)
+    {
+        sqlite3_backup *backup = sqlite3_backup_init(destination, "main", source, "main");
+        if (backup == nullptr)
+            throw DatabaseError("[ERR]: " + std::string(sqlite3_errmsg(destination)));
+
+        int rc;
+        do
         {
+            rc = sqlite3_backup_step(backup, pagesPerStep);
+            // Locks are released between steps: give writers a chance to run
+            if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+                sqlite3_sleep(rc == SQLITE_OK ? 0 : 1);
+        } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+        sqlite3_backup_finish(backup);
+        if (rc != SQLITE_DONE)
+            throw DatabaseError("[ERR]: " + std::string(sqlite3_errstr(rc)));
+    }
+
+    SchemaChanges SQLite::evolveTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns, const SchemaOptions &options)
+    {
+        auto fold = [](std::string text, int (*convert)(int))
+        {
+            for (char &c : text)
+                c = static_cast<char>(convert(static_cast<unsigned char>(c)));
+            return (text);
+        };
+
+        // Column names are case-insensitive, declared types are compared as the query builder writes them
+        std::vector<std::pair<std::string, std::string>> existing;
+        std::unordered_map<std::string, std::string> types;
+        int keyColumns = 0;
+        bool rowidKey = false;
+        RowCallBackWrapper collect([&](IRow &row)
+                                   {
+            std::string name(row.getText(1));
+            std::string type = fold(std::string(row.getText(2)), std::toupper);
+            existing.push_back({name, type});
+            types[fold(name, std::tolower)] = type;
+            if (row.getInt64(5) > 0)
+            {
+                keyColumns++;
+                rowidKey = fold(name, std::tolower) == "_id" && type == "INTEGER";
+            }
+            return (0); });
+        exec("PRAGMA table_info(" + table + ")", {}, &collect);
+        if (existing.empty())
+            throw DatabaseError("[ERR]: no such table: " + table);
+
+        SchemaChanges changes;
+        for (const auto &[columnName, field] : columns)
+        {
+            auto type = types.find(fold(columnName, std::tolower));
+            // _id must alias the rowid, which only a table declaring it so can do
+            if (columnName == "_id")
+                changes.rebuildNeeded |= type == types.end() || !rowidKey || keyColumns != 1;
+            else if (type == types.end())
+                changes.addedColumns.push_back(columnName);
+            else
+                changes.rebuildNeeded |= type->second != qbuilder->columnType(field);
+        }
+        std::sort(changes.addedColumns.begin(), changes.addedColumns.end());
+
+        if (changes.rebuildNeeded && options.rebuild)
+        {
+            changes.rowsCopied = _rebuildTable(table, columns, existing, options);
+            changes.rebuilt = true;
+            return (changes);
+        }
+        if (changes.addedColumns.empty())
+            return (changes);
+
+        // A savepoint also works within the transaction of the caller
+        std::string query = "SAVEPOINT evolve_table;";
+        for (const auto &columnName : changes.addedColumns)
+            query += qbuilder->addColumnQuery(table, columnName, columns.at(columnName));
+        query += "RELEASE evolve_table;";
+        Result<void> result = tryExec(query, nullptr);
+        if (!result)
+        {
+            tryExec("ROLLBACK TO evolve_table; RELEASE evolve_table;", nullptr);
+            result.error().raise();
+        }
+        return (changes);
+    }
+
+    int64_t SQLite::_rebuildTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns,
+                                  const std::vector<std::pair<std::string, std::string>> &existing, const SchemaOptions &options)
+    {
+        if (!sqlite3_get_autocommit(_db))
+            throw DatabaseError("[ERR]: cannot rebuild table " + table + " within a transaction");
+
+        std::string rebuilt = table + "_rebuild";
+        std::string cleanup = "DROP TRIGGER IF EXISTS " + rebuilt + "_insert; DROP TRIGGER IF EXISTS " + rebuilt +
+                              "_update; DROP TRIGGER IF EXISTS " + rebuilt + "_delete; ";
+
+        // Every column of the old table is copied, including the ones the model lacks
+        std::string names;
+        std::string values;
+        std::string extras;
+        bool hasId = false;
+        for (const auto &[columnName, type] : existing)
+        {
+            names += (names.empty() ? "" : ", ") + columnName;
+            values += (values.empty() ? "new." : ", new.") + columnName;
+            hasId |= columnName == "_id";
+            if (columns.find(columnName) == columns.end())
+                extras += "ALTER TABLE " + rebuilt + " ADD COLUMN " + columnName + " " + type + ";";
+        }
+        if (!hasId)
+            throw DatabaseError("[ERR]: cannot rebuild table " + table + " without an _id column");
+
+        std::vector<std::string> objects;
+        RowCallBackWrapper collect([&](IRow &row)
+                                   {
+            objects.push_back(std::string(row.getText(0)));
+            return (0); });
+        exec("SELECT sql FROM sqlite_master WHERE tbl_name = ? AND type IN ('index', 'trigger') AND sql IS NOT NULL;",
+             {FieldInfo::of(table)}, &collect);
+
+        int64_t total = 0;
+        int64_t copied = 0;
+        std::optional<int64_t> lastRow;
+        RowCallBackWrapper count([&](IRow &row)
+                                 {
+            total = row.getInt64(0);
+            if (!row.isNull(1))
+                lastRow = row.getInt64(1);
+            return (0); });
+        try
+        {
+            // Until the swap, triggers mirror the writes of other connections into the new table
+            exec("BEGIN IMMEDIATE;" + cleanup + "DROP TABLE IF EXISTS " + rebuilt + ";" + qbuilder->createTableQuery(rebuilt, columns) + extras +
+                     "CREATE TRIGGER " + rebuilt + "_insert AFTER INSERT ON " + table + " BEGIN INSERT OR REPLACE INTO " + rebuilt +
+                     " (" + names + ") VALUES (" + values + "); END;" +
+                     "CREATE TRIGGER " + rebuilt + "_update AFTER UPDATE ON " + table + " BEGIN DELETE FROM " + rebuilt +
+                     " WHERE _id = old._id; INSERT OR REPLACE INTO " + rebuilt + " (" + names + ") VALUES (" + values + "); END;" +
+                     "CREATE TRIGGER " + rebuilt + "_delete AFTER DELETE ON " + table + " BEGIN DELETE FROM " + rebuilt +
+                     " WHERE _id = old._id; END;",
+                 nullptr);
+            exec("SELECT count(*), max(rowid) FROM " + table + ";", {}, &count);
+            exec("COMMIT;", nullptr);
+
+            // Each batch is a transaction of its own, so that writers only wait for one batch.
+            // Rows inserted since the triggers exist are already mirrored, the copy stops at the last older row.
+            int64_t cursor = std::numeric_limits<int64_t>::min();
+            int64_t batchSize = std::max<int64_t>(options.batchSize, 1);
+            while (lastRow && cursor < *lastRow)
+            {
+                std::optional<int64_t> last;
+                int64_t rows = 0;
+                RowCallBackWrapper bounds([&](IRow &row)
+                                          {
+                    if (!row.isNull(0))
+                        last = row.getInt64(0);
+                    rows = row.getInt64(1);
+                    return (0); });
+
+                exec("BEGIN IMMEDIATE;", nullptr);
+                exec("SELECT max(rowid), count(*) FROM (SELECT rowid FROM " + table + " WHERE rowid > ? AND rowid <= ? ORDER BY rowid LIMIT ?);",
+                     {FieldInfo::of(cursor), FieldInfo::of(*lastRow), FieldInfo::of(batchSize)}, &bounds);
+                if (last)
+                    exec("INSERT OR REPLACE INTO " + rebuilt + " (" + names + ") SELECT " + names + " FROM " + table +
+                             " WHERE rowid > ? AND rowid <= ?;",
+                         {FieldInfo::of(cursor), FieldInfo::of(*last)}, nullptr);
+                exec("COMMIT;", nullptr);
+                if (!last)
+                    break;
+
+                cursor = *last;
+                copied += rows;
+                if (options.progress)
+                    options.progress(SchemaProgress{table, copied, total});
+            }
+
+            std::string swap = "BEGIN IMMEDIATE;" + cleanup + "DROP TABLE " + table + "; ALTER TABLE " + rebuilt + " RENAME TO " + table + ";";
+            for (const auto &object : objects)
+                swap += object + ";";
+            exec(swap + "COMMIT;", nullptr);
+        }
+        catch (...)
+        {
+            if (!sqlite3_get_autocommit(_db))
+                tryExec("ROLLBACK;", nullptr);
+            tryExec(cleanup + "DROP TABLE IF EXISTS " + rebuilt + ";", nullptr);
+            throw;
+        }
+        return (copied);
+    }
+
+    int SQLite::subscribe(const std::string &table, change_callback cb)
+    {
+        int subscription = _nextSubscription++;
+
+        _subscribers.insert({subscription, {table, cb}});
+        _watchedTables[table]++;
+        if (_subscribers.size() == 1 && _connected)
+            _installHooks();
+        return (subscription);
+    }
+
+    void SQLite::unsubscribe(int subscription)
+    {
+        auto subscriber = _subscribers.find(subscription);
+        if (subscriber == _subscribers.end())
+            return;
+
+        if (--_watchedTables[subscriber->second.first] == 0)
+            _watchedTables.erase(subscriber->second.first);
+        _subscribers.erase(subscriber);
+        if (_subscribers.empty() && _connected)
+            _installHooks();
+    }
+
+    void SQLite::_installHooks()
+    {
+        if (_subscribers.empty())
+        {
+            sqlite3_update_hook(_db, nullptr, nullptr);
+            sqlite3_commit_hook(_db, nullptr, nullptr);
+            sqlite3_rollback_hook(_db, nullptr, nullptr);
+            _pendingChanges.clear();
+            _committedChanges.clear();
+            return;
+        }
+
+        sqlite3_update_hook(
+            _db,
+            [](void *ctx, int op, const char *, const char *table, sqlite3_int64 rowid)
+            {
+                SQLite *self = static_cast<SQLite *>(ctx);
+                if (self->_watchedTables.count("") == 0 && self->_watchedTables.count(table) == 0)
+                    return;
+                ChangeOperation change = op == SQLITE_INSERT ? ROW_INSERTED : op == SQLITE_UPDATE ? ROW_UPDATED
+                                                                                                  : ROW_DELETED;
+                self->_pendingChanges.push_back({table, change, rowid});
+            },
+            this);
+        sqlite3_commit_hook(
+            _db,
+            [](void *ctx) -> int
+            {
+                SQLite *self = static_cast<SQLite *>(ctx);
+                self->_committedChanges.insert(self->_committedChanges.end(),
+                                               std::make_move_iterator(self->_pendingChanges.begin()),
+                                               std::make_move_iterator(self->_pendingChanges.end()));
+                self->_pendingChanges.clear();
+                return (0);
+            },
+            this);
+        sqlite3_rollback_hook(
+            _db,
+            [](void *ctx)
+            { static_cast<SQLite *>(ctx)->_pendingChanges.clear(); },
+            this);
+    }
+
+    void SQLite::_discardFailedChanges(std::size_t pending)
+    {
+        // The failed statement was rolled back, but the update hook already saw its rows
+        if (!sqlite3_get_autocommit(_db) && _pendingChanges.size() > pending)
+            _pendingChanges.resize(pending);
+    }
+
+    void SQLite::_settleChanges(bool deliver)
+    {
+        if (_committedChanges.empty())
+            return;
+
+        if (!sqlite3_get_autocommit(_db))
+        {
+            // The commit did not complete and the transaction is still open
+            _pendingChanges.insert(_pendingChanges.begin(),
+                                   std::make_move_iterator(_committedChanges.begin()),
+                                   std::make_move_iterator(_committedChanges.end()));
+            _committedChanges.clear();
+            return;
+        }
+        if (!deliver)
+            return;
+
+        std::vector<ChangeEvent> changes;
+        changes.swap(_committedChanges);
+
+        std::unordered_map<std::string, std::vector<ChangeEvent>> byTable;
+        for (const ChangeEvent &change : changes)
+            byTable[change.table].push_back(change);
+
+        // Subscribers may subscribe or unsubscribe from their callback
+        auto subscribers = _subscribers;
+        for (const auto &[subscription, subscriber] : subscribers)
+        {
+            if (subscriber.first.empty())
+                subscriber.second(changes);
+            else
+            {
+                auto batch = byTable.find(subscriber.first);
+                if (batch != byTable.end())
+                    subscriber.second(batch->second);
+            }
+        }
+    }
+
+    MemoryStats SQLite::memoryStats()
+    {
+        MemoryStats stats;
+        sqlite3_int64 value = 0;
+        sqlite3_int64 highwater = 0;
+        int current = 0;
+        int unused = 0;
+
+        sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &value, &highwater, 0);
+        stats.memoryUsed = value;
+        stats.memoryHighwater = highwater;
+        sqlite3_status64(SQLITE_STATUS_MALLOC_COUNT, &value, &highwater, 0);
+        stats.mallocCount = value;
+        sqlite3_status64(SQLITE_STATUS_PAGECACHE_USED, &value, &highwater, 0);
+        stats.pageCacheUsed = value;
+        sqlite3_status64(SQLITE_STATUS_PAGECACHE_OVERFLOW, &value, &highwater, 0);
+        stats.pageCacheOverflow = value;
+        if (_connected)
+        {
+            sqlite3_db_status(_db, SQLITE_DBSTATUS_CACHE_USED, &current, &unused, 0);
+            stats.cacheUsed = current;
+            sqlite3_db_status(_db, SQLITE_DBSTATUS_SCHEMA_USED, &current, &unused, 0);
+            stats.schemaUsed = current;
+            sqlite3_db_status(_db, SQLITE_DBSTATUS_STMT_USED, &current, &unused, 0);
+            stats.statementsUsed = current;
+            sqlite3_db_status(_db, SQLITE_DBSTATUS_LOOKASIDE_USED, &current, &unused, 0);
+            stats.lookasideUsed = current;
+        }
+        stats.liveModels = LiveModelCounter::count();
+        stats.cachedStatements = static_cast<int64_t>(_statements.size());
+        stats.bufferedChanges = static_cast<int64_t>(_pendingChanges.size() + _committedChanges.size());
+        return (stats);
+    }
+
+    void SQLite::installAllocator(const sqlite3_mem_methods &methods)
+    {
+        if (sqlite3_config(SQLITE_CONFIG_MALLOC, &methods) != SQLITE_OK)
+            throw DatabaseError("[ERR]: Unable to install allocator, SQLite is already initialized");
+    }
+
+    void SQLite::installPageCache(int pageSize, int pages)
+    {
+        int headerSize = 0;
+        sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &headerSize);
+        int slotSize = (pageSize + headerSize + 7) & ~7;
+
+        // The slab must outlive every connection: it is intentionally never released
+        void *slab = std::malloc(static_cast<std::size_t>(slotSize) * pages);
+        if (slab == nullptr || sqlite3_config(SQLITE_CONFIG_PAGECACHE, slab, slotSize, pages) != SQLITE_OK)
+        {
+            std::free(slab);
+            throw DatabaseError("[ERR]: Unable to install page cache, SQLite is already initialized");
+        }
+    }
+
+    void SQLite::setBusyPolicy(const BusyPolicy &policy)
+    {
+        _busyPolicy = policy;
+        if (_connected)
+            _installBusyHandler();
+    }
+
+    BusyStats SQLite::busyStats()
+    {
+        BusyStats stats;
+        stats.waits = _busyWaits;
+        stats.waitTime = std::chrono::microseconds(_busyWaitTime);
+        stats.timeouts = _busyTimeouts;
+        return (stats);
+    }
+
+    void SQLite::_installBusyHandler()
+    {
+        if (_busyPolicy.backoff)
+            sqlite3_busy_handler(_db, _busy, this);
+        else
+            sqlite3_busy_timeout(_db, static_cast<int>(_busyPolicy.timeout.count()));
+    }
+
+    int SQLite::_busy(void *ctx, int attempts)
+    {
+        SQLite *self = static_cast<SQLite *>(ctx);
+        const BusyPolicy &policy = self->_busyPolicy;
+        auto now = std::chrono::steady_clock::now();
+
+        if (attempts == 0)
+        {
+            self->_busyDeadline = now + policy.timeout;
+            if (self->_deadline.active && self->_deadline.deadline < self->_busyDeadline)
+                self->_busyDeadline = self->_deadline.deadline;
+        }
+        if (now >= self->_busyDeadline)
+        {
+            self->_busyTimeouts++;
+            return (0);
+        }
+
+        // Full delay doubles with each attempt, the actual sleep is drawn in its upper half
+        int64_t delay = policy.initialDelay.count() << std::min(attempts, 20);
+        delay = std::max<int64_t>(1, std::min<int64_t>(delay, policy.maxDelay.count()));
+        static thread_local std::minstd_rand random(std::random_device{}());
+        std::uniform_int_distribution<int64_t> jitter(delay / 2, delay);
+        auto sleep = std::min<std::chrono::steady_clock::duration>(
+            std::chrono::microseconds(jitter(random)), self->_busyDeadline - now);
+
+        std::this_thread::sleep_for(sleep);
+        self->_busyWaits++;
+        self->_busyWaitTime += std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - now)
+                                   .count();
+        return (1);
+    }
+
+    ErrorKind SQLite::_classify(int rc) const
+    {
+        bool expired = _deadline.active && std::chrono::steady_clock::now() >= _deadline.deadline;
+
+        if ((rc & 0xff) == SQLITE_INTERRUPT)
+            return ((_cancelled || !expired) ? ERROR_CANCELLED : ERROR_TIMEOUT);
+        if ((rc & 0xff) == SQLITE_BUSY || (rc & 0xff) == SQLITE_LOCKED)
+            return (expired ? ERROR_TIMEOUT : ERROR_BUSY);
+        return (ERROR_DATABASE);
+    }
+
+    Error SQLite::_error(int rc) const
+    {
+        ErrorKind kind = _classify(rc);
+        int extended = sqlite3_extended_errcode(_db);
+        int code = (extended & 0xff) == (rc & 0xff) ? extended : rc;
+
+        if (kind == ERROR_CANCELLED)
+            return (Error(code, kind, "query cancelled"));
+        if (kind == ERROR_TIMEOUT)
+            return (Error(code, kind, (rc & 0xff) == SQLITE_INTERRUPT ? "query timed out" : "query timed out waiting for a lock"));
+        return (Error(code, kind, _failure ? _failure : sqlite3_errstr(rc)));
+    }
+
+    void SQLite::_fail(int rc)
+    {
+        Error error = _error(rc);
+
+        // Unlike the static description of `Error`, exceptions carry the detailed message of the connection
+        if (error.kind() == ERROR_BUSY)
+            throw BusyError("[ERR]: " + std::string(sqlite3_errmsg(_db)));
+        if (error.kind() == ERROR_DATABASE && !_failure)
             throw DatabaseError("[ERR]: " + std::string(sqlite3_errmsg(_db)));
+        error.raise();
+    }
+
+    const std::string &SQLite::_transactionMode(const std::string &query) const
+    {
+        static const std::string immediate = "BEGIN IMMEDIATE;";
+
+        // Cheap filter first, this runs for every statement
+        std::size_t start = query.find_first_not_of(" \t\r\n");
+        if (!_busyPolicy.immediateTransactions || query.size() > 32 || start == std::string::npos ||
+            std::toupper(static_cast<unsigned char>(query[start])) != 'B')
+            return (query);
+
+        // Only a bare BEGIN [TRANSACTION] is rewritten, explicit modes are kept
+        std::istringstream words(query);
+        std::string word;
+        std::vector<std::string> keywords;
+        while (words >> word)
+        {
+            while (!word.empty() && word.back() == ';')
+                word.pop_back();
+            for (char &c : word)
+                c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            if (!word.empty())
+                keywords.push_back(word);
+        }
+        if ((keywords.size() == 1 && keywords[0] == "BEGIN") ||
+            (keywords.size() == 2 && keywords[0] == "BEGIN" && keywords[1] == "TRANSACTION"))
+            return (immediate);
+        return (query);
+    }
+
+    void SQLite::setQueryTimeout(std::chrono::milliseconds timeout)
+    {
+        _queryTimeout = timeout;
+    }
+
+    void SQLite::interrupt()
+    {
+        _cancelled = true;
+        sqlite3_interrupt(_db);
+    }
+
+    IDatabase &SQLite::shard(uint64_t)
+    {
+        return (*this);
+    }
+
+    int SQLite::_armDeadline()
+    {
+        _deadline = QueryDeadline::current();
+        _cancelled = false;
+        if (_queryTimeout.count() > 0)
+        {
+            auto deadline = std::chrono::steady_clock::now() + _queryTimeout;
+            if (!_deadline.active || deadline < _deadline.deadline)
+                _deadline.deadline = deadline;
+            _deadline.active = true;
+        }
+        if (_deadline.token && _deadline.token->isCancelled())
+        {
+            _cancelled = true;
+            return (SQLITE_INTERRUPT);
+        }
+        if (_deadline.active && std::chrono::steady_clock::now() >= _deadline.deadline)
+            return (SQLITE_INTERRUPT);
+
+        if (_deadline.active != _progressInstalled)
+        {
+            sqlite3_progress_handler(_db, _deadline.active ? 256 : 0, _deadline.active ? _progress : nullptr, this);
+            _progressInstalled = _deadline.active;
+        }
+        return (SQLITE_OK);
+    }
+
+    int SQLite::_progress(void *ctx)
+    {
+        SQLite *self = static_cast<SQLite *>(ctx);
+
+        if (self->_deadline.token && self->_deadline.token->isCancelled())
+        {
+            self->_cancelled = true;
+            return (1);
         }
-        // else
-        // {
-        //     std::cout << "Query Successfully executed !" << std::endl;
-        // }
+        return (std::chrono::steady_clock::now() >= self->_deadline.deadline);
     }
 }
\ No newline at end of file
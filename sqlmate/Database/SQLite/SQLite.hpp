@@ -4,9 +4,13 @@
  */
 
 #include "../IDatabase.hpp"
+#include "./PoolAllocator.hpp"
 #include <any>
+#include <atomic>
 #include <typeindex>
+#include <list>
 #include <sstream>
+#include <unordered_set>
 #include <sqlite3.h>
 
 #pragma once
@@ -34,6 +38,10 @@ namespace sqlmate
         /**
          * @brief Connects to the specified SQLite database.
          * 
+         * Besides file paths, `:memory:` and URI filenames are accepted, such as
+         * `file::memory:?cache=shared` for an in-memory database shared by the connections of the process.
+         * An instance already connected is disconnected first, closing its handle and cached statements.
+         * 
          * @param url The file path or URL of the SQLite database.
          * @throw DatabaseError If the connection fails.
          */
@@ -61,9 +69,558 @@ namespace sqlmate
          */
         void exec(std::string query, QueryCallBackWrapper *cb_wrapper) override;
 
+        /**
+         * @brief Executes a single SQL statement with bound parameters on the connected database.
+         * 
+         * The statement is prepared once and kept in a cache keyed by its SQL text, so repeated
+         * queries only pay for binding and stepping. Values are bound with the `sqlite3_bind_*`
+         * function matching their C++ type, and rows are read with `sqlite3_column_*`.
+         * 
+         * @param query The SQL statement, with `?` placeholders.
+         * @param params The values bound to the placeholders, in order.
+         * @param cb_wrapper An optional callback invoked for each result row.
+         * @throw DatabaseError If the statement cannot be prepared, bound or executed.
+         */
+        void exec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a single SQL statement whose parameters are bound by a callback.
+         * 
+         * Shares the statement cache of the other overload. Observers receive no parameters for it.
+         * 
+         * @param query The SQL statement, with `?` placeholders.
+         * @param binder The callback binding the parameters.
+         * @param cb_wrapper An optional callback invoked for each result row.
+         * @throw DatabaseError If the statement cannot be prepared, bound or executed.
+         */
+        void exec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a SQL query, returning failures instead of throwing them.
+         * 
+         * Shares its implementation with `exec()`, which only adds the throwing of the
+         * exception matching the returned result code.
+         * 
+         * @param query The SQL query string to execute.
+         * @param cb_wrapper An optional callback function for processing query results.
+         * @return A success, or the error holding the extended result code of SQLite.
+         */
+        Result<void> tryExec(const std::string &query, QueryCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a single SQL statement with bound parameters, returning failures instead of throwing them.
+         * 
+         * @param query The SQL statement, with `?` placeholders.
+         * @param params The values bound to the placeholders, in order.
+         * @param cb_wrapper An optional callback invoked for each result row.
+         * @return A success, or the error holding the extended result code of SQLite.
+         */
+        Result<void> tryExec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a single SQL statement whose parameters are bound by a callback, returning failures instead of throwing them.
+         * 
+         * @param query The SQL statement, with `?` placeholders.
+         * @param binder The callback binding the parameters.
+         * @param cb_wrapper An optional callback invoked for each result row.
+         * @return A success, or the error holding the extended result code of SQLite.
+         */
+        Result<void> tryExec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Returns the number of rows changed by the last `INSERT`, `UPDATE` or `DELETE` of the
+         *        connection, see `sqlite3_changes64`.
+         * 
+         * Rows changed by triggers and foreign key actions are not counted.
+         */
+        int64_t changes() override;
+
+        /**
+         * @brief Opens a handle for incremental I/O on a BLOB value with `sqlite3_blob_open`.
+         * 
+         * @param table The name of the table holding the BLOB.
+         * @param column The name of the BLOB column.
+         * @param rowid The rowid (`_id`) of the row holding the BLOB.
+         * @param writable True to open the handle for writing, false for read-only access.
+         * @return A handle on the BLOB, closed when released.
+         * @throw DatabaseError If the BLOB cannot be opened.
+         */
+        std::shared_ptr<IBlob> openBlob(const std::string &table, const std::string &column, int64_t rowid, bool writable) override;
+
+        /**
+         * @brief Installs an observer notified of every executed statement.
+         * 
+         * Statements are profiled with `sqlite3_trace_v2`, which reports when each statement starts,
+         * returns a row and completes. The run time is measured between the start and completion
+         * events with a steady clock, SQLite's own profile timing having millisecond resolution.
+         * Tracing is disabled while no observer is installed.
+         * 
+         * @param observer The observer, or `nullptr` to remove the current one.
+         */
+        void setObserver(std::shared_ptr<IQueryObserver> observer) override;
+
+        /**
+         * @brief Enables or disables the query plan analysis diagnostic mode.
+         * 
+         * Each distinct statement is run through `EXPLAIN QUERY PLAN` after its first successful
+         * execution. Up to 4096 analyzed texts are remembered, past which a plan may be reported again. The plan is classified as an index seek (`SEARCH`), a covering index, a full scan
+         * (`SCAN`) and/or a temporary B-tree sort (`USE TEMP B-TREE`).
+         * 
+         * @param reporter The callback receiving the plans, or `nullptr` to disable the analysis.
+         * @param offendersOnly True to only report plans with a full scan or a temporary B-tree.
+         */
+        void setPlanAnalyzer(plan_callback reporter, bool offendersOnly = true) override;
+
+        /**
+         * @brief Copies the whole database to a file with the online backup API.
+         * 
+         * Pages are copied with `sqlite3_backup_step` in batches of `pagesPerStep`, the connection being
+         * released between batches so that other threads can keep writing. The snapshot is written to
+         * `path` suffixed with `.tmp`, then renamed over `path`, so an interrupted snapshot never
+         * replaces a previous one.
+         * 
+         * @param path The path of the snapshot file.
+         * @param pagesPerStep The number of pages copied per step.
+         * @throw DatabaseError If the snapshot fails.
+         */
+        void snapshotTo(const std::string &path, int pagesPerStep = 256) override;
+
+        /**
+         * @brief Replaces the content of the database with a snapshot file with the online backup API.
+         * 
+         * @param path The path of the snapshot file.
+         * @param pagesPerStep The number of pages copied per step.
+         * @throw DatabaseError If the restore fails.
+         */
+        void restoreFrom(const std::string &path, int pagesPerStep = 256) override;
+
+        /**
+         * @brief Brings the columns of a table in line with the fields of a model, see `IDatabase::evolveTable()`.
+         * 
+         * The columns are read with `PRAGMA table_info`. During a rebuild, triggers on the old table
+         * mirror the rows written by other connections into the new one, so that writers are only
+         * blocked for the duration of one batch and of the final swap.
+         * 
+         * @param table The name of the table, which must exist.
+         * @param columns A map of the column names of the model to their field information.
+         * @param options Whether and how the table may be rebuilt.
+         * @return The changes made to the table.
+         * @throw DatabaseError If a change fails, the table being left as it was.
+         */
+        SchemaChanges evolveTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns,
+                                  const SchemaOptions &options = SchemaOptions()) override;
+
+        /**
+         * @brief Subscribes to the committed changes of a table.
+         * 
+         * Row changes are captured with `sqlite3_update_hook` and buffered until the commit hook fires,
+         * the rollback hook discarding them. The batch is delivered when the committing query returns,
+         * once `sqlite3_get_autocommit` confirms that the transaction is closed. Hooks are only
+         * installed while there is at least one subscription.
+         * 
+         * @param table The name of the table to watch, or an empty string for all tables.
+         * @param cb The callback receiving the batches of changes.
+         * @return The identifier of the subscription, to pass to `unsubscribe()`.
+         */
+        int subscribe(const std::string &table, change_callback cb) override;
+
+        /**
+         * @brief Cancels a subscription.
+         * 
+         * @param subscription The identifier returned by `subscribe()`.
+         */
+        void unsubscribe(int subscription) override;
+
+        /**
+         * @brief Returns the memory usage of SQLite, of this connection and of the library.
+         * 
+         * Process-wide figures come from `sqlite3_status64`, connection figures from `sqlite3_db_status`.
+         */
+        MemoryStats memoryStats() override;
+
+        /**
+         * @brief Replaces the memory allocator used by SQLite, such as `PoolAllocator::methods()`.
+         * 
+         * Must be called before any connection is opened.
+         * 
+         * @param methods The allocation functions, copied by SQLite.
+         * @throw DatabaseError If SQLite is already initialized.
+         */
+        static void installAllocator(const sqlite3_mem_methods &methods);
+
+        /**
+         * @brief Preallocates a page cache of fixed-size slots shared by all connections.
+         * 
+         * Pages are served from the slab before falling back to the general allocator, which keeps
+         * the page cache out of the heap. Must be called before any connection is opened.
+         * 
+         * @param pageSize The database page size the slots are sized for.
+         * @param pages The number of slots.
+         * @throw DatabaseError If SQLite is already initialized.
+         */
+        static void installPageCache(int pageSize, int pages);
+
+        /**
+         * @brief Sets how the connection waits for the locks held by other connections.
+         * 
+         * With backoff enabled, a `sqlite3_busy_handler` sleeps between attempts, each delay being
+         * twice the previous one up to `maxDelay` and drawn at random in its upper half so that
+         * competing writers do not retry in lockstep. Without it, `sqlite3_busy_timeout` is used.
+         * 
+         * When `immediateTransactions` is set, plain `BEGIN` statements run as `BEGIN IMMEDIATE`:
+         * the write lock is taken upfront, instead of upgrading a read lock later, which fails at
+         * once with `SQLITE_BUSY` if another connection is writing. Use `BEGIN DEFERRED` explicitly
+         * for read-only transactions.
+         * 
+         * @param policy The busy handling policy.
+         */
+        void setBusyPolicy(const BusyPolicy &policy) override;
+
+        /**
+         * @brief Returns the lock contention counters of the connection.
+         */
+        BusyStats busyStats() override;
+
+        /**
+         * @brief Sets the time each query may run before it is interrupted.
+         * 
+         * Deadlines are enforced by a `sqlite3_progress_handler`, which SQLite calls every few
+         * hundred virtual machine instructions and which aborts the statement once the deadline
+         * passes or the thread's cancellation token is triggered. The handler is only installed
+         * while a query runs under a deadline or a token. An interrupted write inside an explicit
+         * transaction rolls the whole transaction back.
+         * 
+         * @param timeout The time budget of a query, or zero to disable it.
+         */
+        void setQueryTimeout(std::chrono::milliseconds timeout) override;
+
+        /**
+         * @brief Interrupts the query running on the connection with `sqlite3_interrupt`.
+         */
+        void interrupt() override;
+
+        /**
+         * @brief Returns this database, which holds every row.
+         */
+        IDatabase &shard(uint64_t key) override;
+
     private:
         bool _connected; ///< Indicates the connection status to the database.
         sqlite3 *_db; ///< Pointer to the SQLite database instance.
+        /**
+         * @brief A prepared statement of the cache and its place in the least recently used order.
+         */
+        struct CachedStatement
+        {
+            sqlite3_stmt *stmt;                          ///< The prepared statement.
+            std::list<const std::string *>::iterator use; ///< Its entry in `_statementUses`.
+        };
+
+        static constexpr std::size_t _statementCacheSize = 256; ///< Maximum number of cached statements.
+        std::unordered_map<std::string, CachedStatement> _statements; ///< Prepared statements cache keyed by SQL text.
+        std::list<const std::string *> _statementUses; ///< The SQL texts of the cache, most recently used first.
+        std::shared_ptr<IQueryObserver> _observer; ///< Observer notified of every executed statement.
+        const std::vector<FieldInfo> *_currentParams = nullptr; ///< Values bound to the running parameterized statement.
+        bool _cacheHit = false; ///< Whether the running statement was reused from the cache.
+        const char *_failure = nullptr; ///< Static description of the last failure raised by the library rather than SQLite.
+        std::chrono::steady_clock::time_point _traceStart; ///< When the running statement started.
+        int64_t _traceRows = 0; ///< Rows returned so far by the running statement.
+        int64_t _traceChanges = 0; ///< Total changes count of the connection when the running statement started.
+        plan_callback _planReporter; ///< Receives the analyzed query plans, analysis is disabled when empty.
+        bool _planOffendersOnly = true; ///< Whether only offending plans are reported.
+        std::unordered_set<std::string> _explained; ///< SQL texts whose plan was already analyzed.
+        static constexpr std::size_t _explainedLimit = 4096; ///< Maximum number of `_explained` texts, the set being cleared when full.
+        std::unordered_map<int, std::pair<std::string, change_callback>> _subscribers; ///< Change subscribers and their table, by subscription identifier.
+        std::unordered_map<std::string, int> _watchedTables; ///< Number of subscribers per watched table, the empty name watching all tables.
+        int _nextSubscription = 1; ///< Identifier of the next subscription.
+        std::vector<ChangeEvent> _pendingChanges; ///< Changes of the open transaction.
+        std::vector<ChangeEvent> _committedChanges; ///< Changes committed and not delivered yet.
+        BusyPolicy _busyPolicy; ///< How the connection waits for locks.
+        std::chrono::steady_clock::time_point _busyDeadline; ///< When the statement waiting for a lock gives up.
+        std::atomic<int64_t> _busyWaits{0}; ///< Number of waits for a lock.
+        std::atomic<int64_t> _busyWaitTime{0}; ///< Total time spent waiting for locks, in microseconds.
+        std::atomic<int64_t> _busyTimeouts{0}; ///< Number of statements that gave up waiting for a lock.
+        std::chrono::milliseconds _queryTimeout{0}; ///< Time budget of each query, disabled when zero.
+        QueryDeadline _deadline; ///< Deadline and token of the running query.
+        bool _progressInstalled = false; ///< Whether the progress handler is installed.
+        std::atomic<bool> _cancelled{false}; ///< Whether the running query was interrupted by a cancellation rather than its deadline.
+
+        /**
+         * @brief Computes the deadline of a query about to run and installs the progress handler if needed.
+         * 
+         * @return `SQLITE_OK`, or `SQLITE_INTERRUPT` if the deadline has already passed or the token was cancelled.
+         */
+        int _armDeadline();
+
+        /**
+         * @brief `sqlite3_progress_handler` callback interrupting queries past their deadline or cancelled.
+         * 
+         * @param ctx The connection.
+         * @return Non-zero to interrupt the running statement.
+         */
+        static int _progress(void *ctx);
+
+        /**
+         * @brief Installs the busy handler or timeout matching the busy policy.
+         */
+        void _installBusyHandler();
+
+        /**
+         * @brief `sqlite3_busy_handler` callback sleeping with jittered exponential backoff.
+         * 
+         * @param ctx The connection.
+         * @param attempts The number of times the handler was called for the current lock.
+         * @return Non-zero to try again, 0 to give up with `SQLITE_BUSY`.
+         */
+        static int _busy(void *ctx, int attempts);
+
+        /**
+         * @brief Classifies a result code, telling timeouts and cancellations apart with the query's deadline.
+         */
+        ErrorKind _classify(int rc) const;
+
+        /**
+         * @brief Describes a failed SQLite call without allocating.
+         * 
+         * @param rc The result code of the call.
+         * @return The error, holding the extended result code if available.
+         */
+        Error _error(int rc) const;
+
+        /**
+         * @brief Throws the exception matching a failed SQLite call.
+         * 
+         * @param rc The result code of the call.
+         * @throw BusyError If the database is locked.
+         * @throw QueryTimeoutError If the query ran past its deadline.
+         * @throw QueryCancelledError If the query was cancelled.
+         * @throw DatabaseError Otherwise.
+         */
+        [[noreturn]] void _fail(int rc);
+
+        /**
+         * @brief Returns the query to run, turning plain `BEGIN` into `BEGIN IMMEDIATE` if the busy policy asks to.
+         */
+        const std::string &_transactionMode(const std::string &query) const;
+
+        /**
+         * @brief Installs the change hooks if there are subscribers, removes them otherwise.
+         */
+        void _installHooks();
+
+        /**
+         * @brief Settles the committed changes once a query returns.
+         * 
+         * Changes whose commit did not complete, leaving a transaction open, are moved back to the
+         * pending changes. The others are delivered to the subscribers if `deliver` is true, or kept
+         * for the next successful query otherwise.
+         * 
+         * @param deliver True if the query succeeded and subscribers may be called.
+         */
+        void _settleChanges(bool deliver);
+
+        /**
+         * @brief Drops the changes buffered by a failed query, which SQLite rolled back within the open transaction.
+         * 
+         * The changes of a transaction rolled back as a whole are already dropped by the rollback hook.
+         * 
+         * @param pending The number of pending changes before the failed statement ran.
+         */
+        void _discardFailedChanges(std::size_t pending);
+
+        /**
+         * @brief Analyzes the plan of each statement of a query not analyzed yet.
+         * 
+         * @param query The SQL query, possibly made of several statements.
+         */
+        void _analyze(const std::string &query);
+
+        /**
+         * @brief Computes and classifies the plan of a single statement.
+         * 
+         * @param sql The SQL text of the statement.
+         * @param plan The plan to fill.
+         * @return False if the plan cannot be computed.
+         */
+        bool _explain(const std::string &sql, QueryPlan &plan);
+
+        /**
+         * @brief Copies the main database of a connection into the main database of another.
+         * 
+         * @param destination The connection receiving the copy.
+         * @param source The connection to copy.
+         * @param pagesPerStep The number of pages copied per step.
+         * @throw DatabaseError If the copy fails.
+         */
+        static void _backup(sqlite3 *destination, sqlite3 *source, int pagesPerStep);
+
+        /**
+         * @brief Copies the rows of a table to a new table in batches, then swaps the tables, see `evolveTable()`.
+         * 
+         * @param table The name of the table.
+         * @param columns A map of the column names of the model to their field information.
+         * @param existing The columns of the table and their declared types, in order.
+         * @param options The batch size and progress callback.
+         * @return The number of rows copied.
+         * @throw DatabaseError If the rebuild fails, the new table being dropped.
+         */
+        int64_t _rebuildTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns,
+                              const std::vector<std::pair<std::string, std::string>> &existing, const SchemaOptions &options);
+
+        /**
+         * @brief Enables or disables statement tracing depending on whether an observer is installed.
+         */
+        void _installTrace();
+
+        /**
+         * @brief `sqlite3_trace_v2` callback feeding the observer.
+         */
+        static int _trace(unsigned type, void *ctx, void *p, void *x);
+
+        /**
+         * @brief Runs a query made of one or more statements, one statement at a time like `sqlite3_exec`.
+         * 
+         * @param query The SQL query.
+         * @param cb_wrapper An optional callback invoked for each result row.
+         * @return `SQLITE_OK`, or the result code of the failure.
+         */
+        int _execRaw(const std::string &query, QueryCallBackWrapper *cb_wrapper);
+
+        /**
+         * @brief Runs a single cached statement, binding its parameters from a vector or a callback.
+         * 
+         * @param query The SQL statement.
+         * @param params The values bound to the placeholders, or `nullptr`.
+         * @param binder The callback binding the parameters, or `nullptr`.
+         * @param cb_wrapper An optional callback invoked for each result row.
+         * @return `SQLITE_OK`, or the result code of the failure.
+         */
+        int _run(const std::string &query, const std::vector<FieldInfo> *params, const bind_callback *binder, RowCallBackWrapper *cb_wrapper);
+
+        /**
+         * @brief Returns the cached prepared statement for a query, preparing it on first use.
+         * 
+         * Beyond `_statementCacheSize` statements, the least recently used ones that are not running
+         * are finalized, so queries with inlined values do not grow the cache without bound.
+         * 
+         * @param query The SQL statement.
+         * @param stmt Set to the prepared statement.
+         * @return `SQLITE_OK`, or the result code of the failure.
+         */
+        int _prepare(const std::string &query, sqlite3_stmt *&stmt);
+
+        /**
+         * @brief Binds a field's value to a statement parameter.
+         * 
+         * @param stmt The prepared statement.
+         * @param index The 1-based index of the parameter.
+         * @param field The field holding the value.
+         * @return `SQLITE_OK`, or the result code of the failure.
+         */
+        int _bind(sqlite3_stmt *stmt, int index, const FieldInfo &field);
+
+        /**
+         * @class Row
+         * @brief `IRow` implementation reading the current row of a prepared statement.
+         */
+        class Row : public IRow
+        {
+        public:
+            Row(sqlite3_stmt *stmt) : _stmt(stmt) {}
+
+            int columnCount() const override { return sqlite3_column_count(_stmt); }
+            const char *columnName(int col) const override { return sqlite3_column_name(_stmt, col); }
+            bool isNull(int col) const override { return sqlite3_column_type(_stmt, col) == SQLITE_NULL; }
+            int64_t getInt64(int col) const override { return sqlite3_column_int64(_stmt, col); }
+            double getDouble(int col) const override { return sqlite3_column_double(_stmt, col); }
+
+            std::string_view getText(int col) const override
+            {
+                const char *text = reinterpret_cast<const char *>(sqlite3_column_text(_stmt, col));
+                return std::string_view(text ? text : "", sqlite3_column_bytes(_stmt, col));
+            }
+
+            const std::byte *getBlob(int col, std::size_t &size) const override
+            {
+                const void *blob = sqlite3_column_blob(_stmt, col);
+                size = sqlite3_column_bytes(_stmt, col);
+                return static_cast<const std::byte *>(blob);
+            }
+
+        private:
+            sqlite3_stmt *_stmt;
+        };
+
+        /**
+         * @class Params
+         * @brief `IParams` implementation binding the parameters of a prepared statement.
+         */
+        class Params : public IParams
+        {
+        public:
+            Params(sqlite3_stmt *stmt) : _stmt(stmt), _rc(SQLITE_OK) {}
+
+            void bindNull(int index) override { _check(sqlite3_bind_null(_stmt, index)); }
+            void bindInt64(int index, int64_t value) override { _check(sqlite3_bind_int64(_stmt, index, value)); }
+            void bindDouble(int index, double value) override { _check(sqlite3_bind_double(_stmt, index, value)); }
+
+            void bindText(int index, std::string_view value) override
+            {
+                _check(sqlite3_bind_text64(_stmt, index, value.data(), value.size(), SQLITE_STATIC, SQLITE_UTF8));
+            }
+
+            void bindBlob(int index, const void *data, std::size_t size) override
+            {
+                _check(size ? sqlite3_bind_blob64(_stmt, index, data, size, SQLITE_STATIC)
+                            : sqlite3_bind_zeroblob(_stmt, index, 0));
+            }
+
+            void bindZeroBlob(int index, std::size_t size) override { _check(sqlite3_bind_zeroblob64(_stmt, index, size)); }
+
+            /**
+             * @brief Returns the result code of the first failed binding, or `SQLITE_OK`.
+             */
+            int status() const { return _rc; }
+
+        private:
+            sqlite3_stmt *_stmt;
+            int _rc;
+
+            void _check(int rc)
+            {
+                if (_rc == SQLITE_OK)
+                    _rc = rc;
+            }
+        };
+
+        /**
+         * @class Blob
+         * @brief `IBlob` implementation over an `sqlite3_blob` handle.
+         */
+        class Blob : public IBlob
+        {
+        public:
+            Blob(sqlite3 *db, sqlite3_blob *blob) : _db(db), _blob(blob) {}
+            ~Blob() { sqlite3_blob_close(_blob); }
+
+            std::size_t size() const override { return sqlite3_blob_bytes(_blob); }
+
+            void read(std::size_t offset, void *buffer, std::size_t length) const override
+            {
+                if (sqlite3_blob_read(_blob, buffer, static_cast<int>(length), static_cast<int>(offset)) != SQLITE_OK)
+                    throw DatabaseError("[ERR]: " + std::string(sqlite3_errmsg(_db)));
+            }
+
+            void write(std::size_t offset, const void *data, std::size_t length) override
+            {
+                if (sqlite3_blob_write(_blob, data, static_cast<int>(length), static_cast<int>(offset)) != SQLITE_OK)
+                    throw DatabaseError("[ERR]: " + std::string(sqlite3_errmsg(_db)));
+            }
+
+        private:
+            sqlite3 *_db;
+            sqlite3_blob *_blob;
+        };
 
     public:
         /**
@@ -95,16 +652,46 @@ namespace sqlmate
                         query << ", ";
                     first = false;
 
-                    query << columnName << " " << typeToSQLiteType(field.typeId);
+                    // Declared exactly as INTEGER PRIMARY KEY, _id aliases the rowid
                     if (columnName == "_id")
-                        query << " INTEGER PRIMARY KEY";
+                        query << columnName << " INTEGER PRIMARY KEY";
+                    else
+                        query << columnName << " " << typeToSQLiteType(field);
                 }
                 query << ");";
                 return query.str();
             }
 
             /**
-             * @brief Generates a SQL query to insert or replace a record into a table.
+             * @brief Generates a SQL query to add a column to an existing table.
+             * 
+             * @param tableName Name of the table.
+             * @param columnName Name of the added column.
+             * @param field The field information of the column.
+             * @return A SQL query string for adding the column.
+             */
+            std::string addColumnQuery(const std::string &tableName, const std::string &columnName, const FieldInfo &field) const override
+            {
+                return "ALTER TABLE " + tableName + " ADD COLUMN " + columnName + " " + typeToSQLiteType(field) + ";";
+            }
+
+            /**
+             * @brief Returns the SQLite type a column of a field is declared with.
+             * 
+             * @param field The field information of the column.
+             * @return The declared type of the column.
+             */
+            std::string columnType(const FieldInfo &field) const override
+            {
+                return typeToSQLiteType(field);
+            }
+
+            /**
+             * @brief Generates a SQL query to insert a record into a table, or update it if its `_id` exists.
+             * 
+             * The query holds one `?` parameter per value, in the iteration order of `values`.
+             * Updating in place (upsert) rather than replacing avoids deleting and reinserting the row,
+             * and lets `BlobStream` columns bound to NULL keep their stored content.
              * 
              * @param tableName Name of the table.
              * @param values A map of column names to their field values.
@@ -113,7 +700,7 @@ namespace sqlmate
             std::string insertQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &values) const override
             {
                 std::ostringstream query;
-                query << "INSERT OR REPLACE INTO " << tableName << " (";
+                query << "INSERT INTO " << tableName << " (";
 
                 bool first = true;
                 for (const auto &[columnName, field] : values)
@@ -127,16 +714,29 @@ namespace sqlmate
 
                 query << ") VALUES (";
 
-                first = true;
-                for (const auto &[columnName, field] : values)
+                for (std::size_t i = 0; i < values.size(); i++)
+                    query << (i ? ", ?" : "?");
+                query << ")";
+
+                if (values.find("_id") != values.end())
                 {
-                    if (!first)
-                        query << ", ";
-                    first = false;
-                    query << formatValue(field);
+                    query << " ON CONFLICT(_id) DO ";
+                    first = true;
+                    for (const auto &[columnName, field] : values)
+                    {
+                        if (columnName == "_id")
+                            continue;
+                        query << (first ? "UPDATE SET " : ", ") << columnName << " = ";
+                        first = false;
+                        if (field.typeId == typeid(BlobStream))
+                            query << "coalesce(excluded." << columnName << ", " << columnName << ")";
+                        else
+                            query << "excluded." << columnName;
+                    }
+                    if (first)
+                        query << "NOTHING";
                 }
-
-                query << ");";
+                query << ";";
                 return query.str();
             }
 
@@ -162,6 +762,45 @@ namespace sqlmate
                 return query.str();
             }
 
+            /**
+             * @brief Generates a SQL query to select the given columns of records from a table.
+             * 
+             * `BlobStream` columns are selected as `length(column)` so their content is not loaded.
+             * 
+             * @param tableName Name of the table.
+             * @param columns A map of column names to their field information.
+             * @param condition An optional WHERE condition for filtering records.
+             * @param limit An optional limit for the number of records to return.
+             * @return A SQL query string for selecting records.
+             */
+            std::string selectQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &columns,
+                                    const std::string &condition = "", int limit = -1) const override
+            {
+                std::ostringstream query;
+                query << "SELECT ";
+
+                bool first = true;
+                for (const auto &[columnName, field] : columns)
+                {
+                    if (!first)
+                        query << ", ";
+                    first = false;
+
+                    if (field.typeId == typeid(BlobStream))
+                        query << "length(" << columnName << ") AS " << columnName;
+                    else
+                        query << columnName;
+                }
+                query << " FROM " << tableName;
+                if (!condition.empty())
+                    query << " WHERE " << condition;
+                if (limit > 0)
+                    query << " LIMIT " << limit;
+                query << ";";
+
+                return query.str();
+            }
+
             /**
              * @brief Generates a SQL query to delete a record by ID from a table.
              * 
@@ -176,6 +815,55 @@ namespace sqlmate
                 return query.str();
             }
             
+            /**
+             * @brief Generates a SQL query to delete the records of a table matching a condition.
+             * 
+             * Deleting every record still goes through a `WHERE` clause: the truncate optimization of
+             * a bare `DELETE FROM` skips the update hook, and change subscribers would miss the rows.
+             * 
+             * @param tableName Name of the table.
+             * @param condition The WHERE condition, or an empty string for every record.
+             * @return A SQL query string for deleting the records.
+             */
+            std::string deleteWhereQuery(const std::string &tableName, const std::string &condition) const override
+            {
+                std::ostringstream query;
+                query << "DELETE FROM " << tableName << " WHERE " << (condition.empty() ? "1" : condition) << ";";
+                return query.str();
+            }
+
+            /**
+             * @brief Generates a SQL query to set columns of the records of a table matching a condition.
+             * 
+             * The query holds one `?` parameter per value, in the iteration order of `values`, before
+             * the parameters of `condition`.
+             * 
+             * @param tableName Name of the table.
+             * @param values A map of the updated column names to their new values.
+             * @param condition The WHERE condition, or an empty string for every record.
+             * @return A SQL query string for updating the records.
+             */
+            std::string updateWhereQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &values,
+                                         const std::string &condition) const override
+            {
+                std::ostringstream query;
+                query << "UPDATE " << tableName << " SET ";
+
+                bool first = true;
+                for (const auto &[columnName, field] : values)
+                {
+                    if (!first)
+                        query << ", ";
+                    first = false;
+
+                    query << columnName << " = ?";
+                }
+                if (!condition.empty())
+                    query << " WHERE " << condition;
+                query << ";";
+                return query.str();
+            }
+
             /**
              * @brief Generates a SQL query to drop a table.
              * 
@@ -187,47 +875,113 @@ namespace sqlmate
                 return "DROP TABLE IF EXISTS " + tableName + ";";
             }
 
-        private:
             /**
-             * @brief Maps a C++ type to an SQLite data type.
+             * @brief Generates the SQL statements creating the FTS5 index of a table.
              * 
-             * @param typeId The C++ type index.
-             * @return The corresponding SQLite data type as a string.
-             * @throw QueryBuilderError If the type is not supported.
+             * The index is an external-content FTS5 table named `<table>_fts`, whose rowid is the
+             * `_id` of the indexed row, so the text is not stored twice. Insert, update and delete
+             * triggers on the table keep it in sync, including for rows written outside the models.
+             * The index is rebuilt once if it is empty while the table is not, which happens when
+             * full-text indexing is added to an existing table.
+             * 
+             * @param tableName The name of the indexed table.
+             * @param columns The names of the indexed text columns.
+             * @return A SQL string made of several statements.
              */
-            std::string typeToSQLiteType(const std::type_index &typeId) const
-            {
-                if (typeId == typeid(int))
-                    return "INTEGER";
-                else if (typeId == typeid(double))
-                    return "REAL";
-                else if (typeId == typeid(std::string))
-                    return "TEXT";
-                else if (typeId == typeid(bool))
-                    return "BOOLEAN"; // SQLite uses INTEGER for boolean values
-                else
-                    throw QueryBuilderError("Unsupported type for SQLite");
+            std::string createFullTextQuery(const std::string &tableName, const std::vector<std::string> &columns) const override
+            {
+                std::string fts = tableName + "_fts";
+                std::ostringstream query;
+                std::ostringstream names;
+                std::ostringstream values;
+                std::ostringstream oldValues;
+                std::ostringstream changed;
+
+                for (std::size_t i = 0; i < columns.size(); i++)
+                {
+                    names << (i ? ", " : "") << columns[i];
+                    values << ", new." << columns[i];
+                    oldValues << ", old." << columns[i];
+                    changed << (i ? " OR " : "") << "old." << columns[i] << " IS NOT new." << columns[i];
+                }
+
+                query << "CREATE VIRTUAL TABLE IF NOT EXISTS " << fts << " USING fts5(" << names.str()
+                      << ", content='" << tableName << "', content_rowid='_id');";
+                query << "CREATE TRIGGER IF NOT EXISTS " << fts << "_insert AFTER INSERT ON " << tableName << " BEGIN "
+                      << "INSERT INTO " << fts << " (rowid, " << names.str() << ") VALUES (new._id" << values.str() << "); END;";
+                query << "CREATE TRIGGER IF NOT EXISTS " << fts << "_delete AFTER DELETE ON " << tableName << " BEGIN "
+                      << "INSERT INTO " << fts << " (" << fts << ", rowid, " << names.str() << ") VALUES ('delete', old._id" << oldValues.str() << "); END;";
+                // Upserts set every column, only reindex rows whose indexed text changed
+                query << "CREATE TRIGGER IF NOT EXISTS " << fts << "_update AFTER UPDATE ON " << tableName
+                      << " WHEN " << changed.str() << " BEGIN "
+                      << "INSERT INTO " << fts << " (" << fts << ", rowid, " << names.str() << ") VALUES ('delete', old._id" << oldValues.str() << "); "
+                      << "INSERT INTO " << fts << " (rowid, " << names.str() << ") VALUES (new._id" << values.str() << "); END;";
+                query << "INSERT INTO " << fts << " (" << fts << ") SELECT 'rebuild' WHERE NOT EXISTS (SELECT 1 FROM " << fts
+                      << "_docsize) AND EXISTS (SELECT 1 FROM " << tableName << ");";
+                return query.str();
+            }
+
+            /**
+             * @brief Generates a SQL query for selecting the rows of a table matching an FTS5 query, by `bm25` rank.
+             * 
+             * @param tableName The name of the indexed table.
+             * @param columns A map of column names to their field information.
+             * @return A SQL query string with the full-text query and the limit as parameters.
+             */
+            std::string searchQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &columns) const override
+            {
+                std::string fts = tableName + "_fts";
+                std::ostringstream query;
+                query << "SELECT ";
+
+                bool first = true;
+                for (const auto &[columnName, field] : columns)
+                {
+                    if (!first)
+                        query << ", ";
+                    first = false;
+
+                    if (field.typeId == typeid(BlobStream))
+                        query << "length(" << tableName << "." << columnName << ") AS " << columnName;
+                    else
+                        query << tableName << "." << columnName;
+                }
+                query << ", " << fts << ".rank AS _rank FROM " << fts << " JOIN " << tableName << " ON " << tableName << "._id = " << fts << ".rowid"
+                      << " WHERE " << fts << " MATCH ? ORDER BY " << fts << ".rank LIMIT ?;";
+                return query.str();
             }
 
+        private:
             /**
-             * @brief Formats a field's value for use in a SQL query.
+             * @brief Maps a field's C++ type to an SQLite data type.
+             * 
+             * `std::optional` fields map to the type of their value, SQLite columns being nullable by default.
              * 
-             * @param field The field information containing the value and type.
-             * @return The formatted value as a string.
-             * @throw QueryBuilderError If the value's type is not supported.
+             * @param field The field information containing the type.
+             * @return The corresponding SQLite data type as a string.
+             * @throw QueryBuilderError If the type is not supported.
              */
-            std::string formatValue(const FieldInfo &field) const
-            {
-                if (field.typeId == typeid(int))
-                    return std::to_string(std::any_cast<std::reference_wrapper<int>>(field.value).get());
-                else if (field.typeId == typeid(double))
-                    return std::to_string(std::any_cast<std::reference_wrapper<double>>(field.value).get());
-                else if (field.typeId == typeid(std::string))
-                    return "'" + std::any_cast<std::reference_wrapper<std::string>>(field.value).get() + "'";
-                else if (field.typeId == typeid(bool))
-                    return std::to_string(std::any_cast<std::reference_wrapper<bool>>(field.value).get() ? 1 : 0);
-                else
-                    throw QueryBuilderError("Unsupported type for value formatting");
+            std::string typeToSQLiteType(const FieldInfo &field) const
+            {
+                std::string type;
+                bool supported = visitField(field, [&](auto &value)
+                                            {
+                    using T = std::decay_t<decltype(value)>;
+                    using V = typename std::conditional_t<is_optional<T>::value, T, std::optional<T>>::value_type;
+
+                    if constexpr (std::is_same<V, bool>::value)
+                        type = "BOOLEAN"; // SQLite uses INTEGER for boolean values
+                    else if constexpr (std::is_integral<V>::value)
+                        type = "INTEGER";
+                    else if constexpr (std::is_floating_point<V>::value)
+                        type = "REAL";
+                    else if constexpr (std::is_same<V, std::string>::value)
+                        type = "TEXT";
+                    else
+                        type = "BLOB"; });
+                if (!supported)
+                    throw QueryBuilderError("Unsupported type for SQLite");
+                return type;
             }
         };
     };
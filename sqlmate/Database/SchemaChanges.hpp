@@ -0,0 +1,54 @@
+/**
+ * @file SchemaChanges.hpp
+ * @brief Defines the schema evolution types in the sqlmate namespace.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @struct SchemaProgress
+     * @brief Describes the progress of a table rebuild, see `IDatabase::evolveTable()`.
+     */
+    struct SchemaProgress
+    {
+        std::string table;      /**< The rebuilt table. */
+        int64_t rowsCopied = 0; /**< Rows copied to the new table so far. */
+        int64_t rowsTotal = 0;  /**< Rows of the table when the rebuild started. */
+    };
+
+    /**
+     * @typedef schema_progress_callback
+     * @brief Alias for a function called after each batch of a table rebuild.
+     */
+    typedef std::function<void(const SchemaProgress &)> schema_progress_callback;
+
+    /**
+     * @struct SchemaOptions
+     * @brief Describes how `IDatabase::evolveTable()` brings a table to the columns of a model.
+     */
+    struct SchemaOptions
+    {
+        bool rebuild = true;               /**< True to rebuild the table when adding columns is not enough, false to only add columns. */
+        int64_t batchSize = 10000;         /**< Rows copied per transaction by a rebuild. */
+        schema_progress_callback progress; /**< Called after each batch of a rebuild, if set. */
+    };
+
+    /**
+     * @struct SchemaChanges
+     * @brief Describes the changes made by `IDatabase::evolveTable()`.
+     */
+    struct SchemaChanges
+    {
+        std::vector<std::string> addedColumns; /**< Columns added in place with `ALTER TABLE ... ADD COLUMN`. */
+        bool rebuildNeeded = false;            /**< Whether a column type or the `_id` key differs from the model. */
+        bool rebuilt = false;                  /**< Whether the table was rebuilt. */
+        int64_t rowsCopied = 0;                /**< Rows copied by the rebuild. */
+    };
+} // namespace sqlmate
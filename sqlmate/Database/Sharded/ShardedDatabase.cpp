@@ -0,0 +1,614 @@
+#include "./ShardedDatabase.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+namespace sqlmate
+{
+    namespace
+    {
+        /**
+         * @brief Checks whether a query starts with a keyword, ignoring case and leading blanks.
+         */
+        bool startsWith(const std::string &query, const std::string &keyword)
+        {
+            std::size_t start = 0;
+            while (start < query.size() && std::isspace(static_cast<unsigned char>(query[start])))
+                start++;
+            if (query.size() - start < keyword.size())
+                return (false);
+            for (std::size_t i = 0; i < keyword.size(); i++)
+                if (std::toupper(static_cast<unsigned char>(query[start + i])) != keyword[i])
+                    return (false);
+            return (true);
+        }
+
+        /**
+         * @brief Gives a worker thread the query context and deadline of the calling thread while in scope.
+         */
+        struct CallerScope
+        {
+            QueryContext context;
+            QueryDeadline deadline;
+
+            CallerScope(const QueryContext &callerContext, const QueryDeadline &callerDeadline)
+                : context(QueryContext::current()), deadline(QueryDeadline::current())
+            {
+                QueryContext::current() = callerContext;
+                QueryDeadline::current() = callerDeadline;
+            }
+
+            ~CallerScope()
+            {
+                QueryContext::current() = context;
+                QueryDeadline::current() = deadline;
+            }
+        };
+
+        /**
+         * @brief The rows changed by the last statement the calling thread broadcast, see `ShardedDatabase::changes()`.
+         */
+        thread_local int64_t broadcastChanges = 0;
+    }
+
+    ShardedDatabase::ShardedDatabase(const std::vector<std::shared_ptr<IDatabase>> &shards)
+    {
+        if (shards.empty())
+            throw DatabaseError("[ERR]: a sharded database needs at least one shard");
+        for (const auto &db : shards)
+            _shards.push_back(std::make_unique<Shard>(db));
+        for (std::size_t i = 1; i < shards.size(); i++)
+            _workers.push_back(std::make_unique<Worker>());
+        qbuilder = shards.front()->qbuilder;
+    }
+
+    ShardedDatabase::~ShardedDatabase()
+    {
+        _workers.clear();
+    }
+
+    void ShardedDatabase::connect(std::string url)
+    {
+        _forgetSchema();
+        for (std::size_t i = 0; i < _shards.size(); i++)
+            _shards[i]->connect(shardUrl(url, i));
+    }
+
+    bool ShardedDatabase::isConnected()
+    {
+        for (auto &shard : _shards)
+            if (!shard->isConnected())
+                return (false);
+        return (true);
+    }
+
+    void ShardedDatabase::disconnect()
+    {
+        _forgetSchema();
+        for (auto &shard : _shards)
+            shard->disconnect();
+    }
+
+    void ShardedDatabase::exec(std::string query, QueryCallBackWrapper *cb_wrapper)
+    {
+        if (cb_wrapper == nullptr && _alreadyCreated(query))
+            return;
+
+        auto serialized = _serialize(cb_wrapper);
+        _broadcast([&](IDatabase &db)
+                   { db.exec(query, serialized.get()); });
+
+        if (cb_wrapper == nullptr && startsWith(query, "CREATE ") && query.find("IF NOT EXISTS") != std::string::npos)
+        {
+            std::lock_guard<std::mutex> lock(_schemaMutex);
+            _schemaQueries.insert(query);
+        }
+    }
+
+    void ShardedDatabase::exec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper)
+    {
+        auto serialized = _serialize(cb_wrapper);
+        _broadcast([&](IDatabase &db)
+                   { db.exec(query, params, serialized.get()); });
+    }
+
+    void ShardedDatabase::exec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper)
+    {
+        auto serialized = _serialize(cb_wrapper);
+        BindCallBackWrapper serializedBinder = _serialize(binder);
+        _broadcast([&](IDatabase &db)
+                   { db.exec(query, serializedBinder, serialized.get()); });
+    }
+
+    Result<void> ShardedDatabase::tryExec(const std::string &query, QueryCallBackWrapper *cb_wrapper)
+    {
+        auto serialized = _serialize(cb_wrapper);
+        return (_tryBroadcast([&](IDatabase &db)
+                              { return db.tryExec(query, serialized.get()); }));
+    }
+
+    Result<void> ShardedDatabase::tryExec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper)
+    {
+        auto serialized = _serialize(cb_wrapper);
+        return (_tryBroadcast([&](IDatabase &db)
+                              { return db.tryExec(query, params, serialized.get()); }));
+    }
+
+    Result<void> ShardedDatabase::tryExec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper)
+    {
+        auto serialized = _serialize(cb_wrapper);
+        BindCallBackWrapper serializedBinder = _serialize(binder);
+        return (_tryBroadcast([&](IDatabase &db)
+                              { return db.tryExec(query, serializedBinder, serialized.get()); }));
+    }
+
+    int64_t ShardedDatabase::changes()
+    {
+        return (broadcastChanges);
+    }
+
+    std::shared_ptr<IBlob> ShardedDatabase::openBlob(const std::string &table, const std::string &column, int64_t rowid, bool writable)
+    {
+        for (std::size_t i = 0; i + 1 < _shards.size(); i++)
+        {
+            try
+            {
+                return (_shards[i]->openBlob(table, column, rowid, writable));
+            }
+            catch (const DatabaseError &)
+            {
+            }
+        }
+        return (_shards.back()->openBlob(table, column, rowid, writable));
+    }
+
+    void ShardedDatabase::setObserver(std::shared_ptr<IQueryObserver> observer)
+    {
+        for (auto &shard : _shards)
+            shard->setObserver(observer);
+    }
+
+    void ShardedDatabase::setPlanAnalyzer(plan_callback reporter, bool offendersOnly)
+    {
+        for (auto &shard : _shards)
+            shard->setPlanAnalyzer(reporter, offendersOnly);
+    }
+
+    void ShardedDatabase::snapshotTo(const std::string &path, int pagesPerStep)
+    {
+        for (std::size_t i = 0; i < _shards.size(); i++)
+            _shards[i]->snapshotTo(shardUrl(path, i), pagesPerStep);
+    }
+
+    void ShardedDatabase::restoreFrom(const std::string &path, int pagesPerStep)
+    {
+        _forgetSchema();
+        for (std::size_t i = 0; i < _shards.size(); i++)
+            _shards[i]->restoreFrom(shardUrl(path, i), pagesPerStep);
+    }
+
+    SchemaChanges ShardedDatabase::evolveTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns, const SchemaOptions &options)
+    {
+        SchemaChanges changes;
+        for (auto &shard : _shards)
+        {
+            SchemaChanges current = shard->evolveTable(table, columns, options);
+            for (const auto &column : current.addedColumns)
+                if (std::find(changes.addedColumns.begin(), changes.addedColumns.end(), column) == changes.addedColumns.end())
+                    changes.addedColumns.push_back(column);
+            changes.rebuildNeeded |= current.rebuildNeeded;
+            changes.rebuilt |= current.rebuilt;
+            changes.rowsCopied += current.rowsCopied;
+        }
+        std::sort(changes.addedColumns.begin(), changes.addedColumns.end());
+        return (changes);
+    }
+
+    int ShardedDatabase::subscribe(const std::string &table, change_callback cb)
+    {
+        std::vector<int> subscriptions;
+        for (auto &shard : _shards)
+            subscriptions.push_back(shard->subscribe(table, cb));
+
+        std::lock_guard<std::mutex> lock(_subscriptionsMutex);
+        _subscriptions.insert({_nextSubscription, subscriptions});
+        return (_nextSubscription++);
+    }
+
+    void ShardedDatabase::unsubscribe(int subscription)
+    {
+        std::vector<int> subscriptions;
+        {
+            std::lock_guard<std::mutex> lock(_subscriptionsMutex);
+            auto found = _subscriptions.find(subscription);
+            if (found == _subscriptions.end())
+                return;
+            subscriptions = found->second;
+            _subscriptions.erase(found);
+        }
+        for (std::size_t i = 0; i < _shards.size(); i++)
+            _shards[i]->unsubscribe(subscriptions[i]);
+    }
+
+    MemoryStats ShardedDatabase::memoryStats()
+    {
+        // The engine and model counters are process-wide, only the connection ones add up
+        MemoryStats stats = _shards.front()->memoryStats();
+        for (std::size_t i = 1; i < _shards.size(); i++)
+        {
+            MemoryStats shard = _shards[i]->memoryStats();
+            stats.cacheUsed += shard.cacheUsed;
+            stats.schemaUsed += shard.schemaUsed;
+            stats.statementsUsed += shard.statementsUsed;
+            stats.lookasideUsed += shard.lookasideUsed;
+            stats.cachedStatements += shard.cachedStatements;
+            stats.bufferedChanges += shard.bufferedChanges;
+        }
+        return (stats);
+    }
+
+    void ShardedDatabase::setBusyPolicy(const BusyPolicy &policy)
+    {
+        for (auto &shard : _shards)
+            shard->setBusyPolicy(policy);
+    }
+
+    BusyStats ShardedDatabase::busyStats()
+    {
+        BusyStats stats;
+        for (auto &shard : _shards)
+        {
+            BusyStats current = shard->busyStats();
+            stats.waits += current.waits;
+            stats.waitTime += current.waitTime;
+            stats.timeouts += current.timeouts;
+        }
+        return (stats);
+    }
+
+    void ShardedDatabase::setQueryTimeout(std::chrono::milliseconds timeout)
+    {
+        for (auto &shard : _shards)
+            shard->setQueryTimeout(timeout);
+    }
+
+    void ShardedDatabase::interrupt()
+    {
+        for (auto &shard : _shards)
+            shard->interrupt();
+    }
+
+    IDatabase &ShardedDatabase::shard(uint64_t key)
+    {
+        // Mixes the key so that sequential keys and poor hashes still spread evenly
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return (*_shards[key % _shards.size()]);
+    }
+
+    std::size_t ShardedDatabase::shardCount() const
+    {
+        return (_shards.size());
+    }
+
+    std::string ShardedDatabase::shardUrl(const std::string &url, std::size_t index)
+    {
+        if (url == ":memory:")
+            return (url);
+
+        std::size_t slash = url.find_last_of('/');
+        std::size_t dot = url.find_last_of('.');
+        std::size_t name = (slash == std::string::npos ? 0 : slash + 1);
+        if (dot == std::string::npos || dot <= name)
+            return (url + "." + std::to_string(index));
+        return (url.substr(0, dot) + "." + std::to_string(index) + url.substr(dot));
+    }
+
+    bool ShardedDatabase::_alreadyCreated(const std::string &query)
+    {
+        std::lock_guard<std::mutex> lock(_schemaMutex);
+        if (startsWith(query, "DROP ") || startsWith(query, "ALTER "))
+            _schemaQueries.clear();
+        return (_schemaQueries.count(query) != 0);
+    }
+
+    void ShardedDatabase::_forgetSchema()
+    {
+        std::lock_guard<std::mutex> lock(_schemaMutex);
+        _schemaQueries.clear();
+    }
+
+    void ShardedDatabase::_broadcast(const std::function<void(IDatabase &)> &call)
+    {
+        // Reads the changes of each shard before another thread can run a statement on it
+        std::atomic<int64_t> changes{0};
+        auto run = [&](Shard &shard)
+        {
+            std::lock_guard<std::recursive_mutex> lock(shard.mutex());
+            call(shard);
+            changes += shard.changes();
+        };
+
+        if (_shards.size() == 1)
+        {
+            run(*_shards.front());
+            broadcastChanges = changes;
+            return;
+        }
+
+        QueryContext context = QueryContext::current();
+        QueryDeadline deadline = QueryDeadline::current();
+        std::vector<std::future<void>> others;
+        for (std::size_t i = 1; i < _shards.size(); i++)
+            others.push_back(_workers[i - 1]->post([&, i]()
+                                                   {
+                CallerScope scope(context, deadline);
+                run(*_shards[i]); }));
+
+        // The first shard runs on the calling thread
+        std::exception_ptr failure;
+        try
+        {
+            run(*_shards.front());
+        }
+        catch (...)
+        {
+            failure = std::current_exception();
+        }
+        for (auto &other : others)
+        {
+            try
+            {
+                other.get();
+            }
+            catch (...)
+            {
+                if (!failure)
+                    failure = std::current_exception();
+            }
+        }
+        broadcastChanges = changes;
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+
+    Result<void> ShardedDatabase::_tryBroadcast(const std::function<Result<void>(IDatabase &)> &call)
+    {
+        std::vector<Result<void>> results(_shards.size());
+        _broadcast([&](IDatabase &db)
+                   {
+            for (std::size_t i = 0; i < _shards.size(); i++)
+                if (_shards[i].get() == &db)
+                    results[i] = call(db); });
+        for (const auto &result : results)
+            if (!result)
+                return (result);
+        return (Result<void>());
+    }
+
+    std::unique_ptr<RowCallBackWrapper> ShardedDatabase::_serialize(RowCallBackWrapper *cb_wrapper)
+    {
+        if (cb_wrapper == nullptr)
+            return (nullptr);
+        row_callback cb = cb_wrapper->get();
+        return (std::make_unique<RowCallBackWrapper>([this, cb](IRow &row) -> int
+                                                     {
+            std::lock_guard<std::mutex> lock(_rowMutex);
+            return cb(row); }));
+    }
+
+    std::unique_ptr<QueryCallBackWrapper> ShardedDatabase::_serialize(QueryCallBackWrapper *cb_wrapper)
+    {
+        if (cb_wrapper == nullptr)
+            return (nullptr);
+        db_callback cb = cb_wrapper->get();
+        return (std::make_unique<QueryCallBackWrapper>([this, cb](int count, char **values, char **names) -> int
+                                                       {
+            std::lock_guard<std::mutex> lock(_rowMutex);
+            return cb(count, values, names); }));
+    }
+
+    BindCallBackWrapper ShardedDatabase::_serialize(const BindCallBackWrapper &binder)
+    {
+        const bind_callback &cb = binder.get();
+        return (BindCallBackWrapper([this, &cb](IParams &params)
+                                    {
+            std::lock_guard<std::mutex> lock(_rowMutex);
+            cb(params); }));
+    }
+
+    ShardedDatabase::Worker::Worker() : _thread([this]()
+                                                {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _ready.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+            if (_queue.empty())
+                return;
+            std::packaged_task<void()> call = std::move(_queue.front());
+            _queue.pop_front();
+            lock.unlock();
+            call();
+            lock.lock();
+        } })
+    {
+    }
+
+    ShardedDatabase::Worker::~Worker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _ready.notify_one();
+        _thread.join();
+    }
+
+    std::future<void> ShardedDatabase::Worker::post(std::function<void()> call)
+    {
+        std::packaged_task<void()> task(std::move(call));
+        std::future<void> result = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.push_back(std::move(task));
+        }
+        _ready.notify_one();
+        return (result);
+    }
+
+    ShardedDatabase::Shard::Shard(std::shared_ptr<IDatabase> db) : _db(db)
+    {
+        qbuilder = db->qbuilder;
+    }
+
+    void ShardedDatabase::Shard::connect(std::string url)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->connect(url);
+    }
+
+    bool ShardedDatabase::Shard::isConnected()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->isConnected());
+    }
+
+    void ShardedDatabase::Shard::disconnect()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->disconnect();
+    }
+
+    void ShardedDatabase::Shard::exec(std::string query, QueryCallBackWrapper *cb_wrapper)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->exec(query, cb_wrapper);
+    }
+
+    void ShardedDatabase::Shard::exec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->exec(query, params, cb_wrapper);
+    }
+
+    void ShardedDatabase::Shard::exec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->exec(query, binder, cb_wrapper);
+    }
+
+    Result<void> ShardedDatabase::Shard::tryExec(const std::string &query, QueryCallBackWrapper *cb_wrapper)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->tryExec(query, cb_wrapper));
+    }
+
+    Result<void> ShardedDatabase::Shard::tryExec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->tryExec(query, params, cb_wrapper));
+    }
+
+    Result<void> ShardedDatabase::Shard::tryExec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->tryExec(query, binder, cb_wrapper));
+    }
+
+    int64_t ShardedDatabase::Shard::changes()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->changes());
+    }
+
+    std::shared_ptr<IBlob> ShardedDatabase::Shard::openBlob(const std::string &table, const std::string &column, int64_t rowid, bool writable)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->openBlob(table, column, rowid, writable));
+    }
+
+    void ShardedDatabase::Shard::setObserver(std::shared_ptr<IQueryObserver> observer)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->setObserver(observer);
+    }
+
+    void ShardedDatabase::Shard::setPlanAnalyzer(plan_callback reporter, bool offendersOnly)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->setPlanAnalyzer(reporter, offendersOnly);
+    }
+
+    void ShardedDatabase::Shard::snapshotTo(const std::string &path, int pagesPerStep)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->snapshotTo(path, pagesPerStep);
+    }
+
+    void ShardedDatabase::Shard::restoreFrom(const std::string &path, int pagesPerStep)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->restoreFrom(path, pagesPerStep);
+    }
+
+    SchemaChanges ShardedDatabase::Shard::evolveTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns, const SchemaOptions &options)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->evolveTable(table, columns, options));
+    }
+
+    int ShardedDatabase::Shard::subscribe(const std::string &table, change_callback cb)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->subscribe(table, cb));
+    }
+
+    void ShardedDatabase::Shard::unsubscribe(int subscription)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->unsubscribe(subscription);
+    }
+
+    MemoryStats ShardedDatabase::Shard::memoryStats()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->memoryStats());
+    }
+
+    void ShardedDatabase::Shard::setBusyPolicy(const BusyPolicy &policy)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->setBusyPolicy(policy);
+    }
+
+    BusyStats ShardedDatabase::Shard::busyStats()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return (_db->busyStats());
+    }
+
+    void ShardedDatabase::Shard::setQueryTimeout(std::chrono::milliseconds timeout)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _db->setQueryTimeout(timeout);
+    }
+
+    void ShardedDatabase::Shard::interrupt()
+    {
+        // Not serialized, to reach the query holding the lock
+        _db->interrupt();
+    }
+
+    IDatabase &ShardedDatabase::Shard::shard(uint64_t)
+    {
+        return (*this);
+    }
+
+    std::recursive_mutex &ShardedDatabase::Shard::mutex()
+    {
+        return (_mutex);
+    }
+}
@@ -0,0 +1,346 @@
+/**
+ * @file ShardedDatabase.hpp
+ * @brief Logical database spreading the rows of models across several databases.
+ */
+
+#include "../IDatabase.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @class ShardedDatabase
+     * @brief A logical database made of several databases, each holding a share of the rows.
+     *
+     * Models route `save()`, `remove()` and `findOne()` to the shard given by a hash of their `_id`,
+     * or of the field declared with `SHARD_KEY`, through `shard()`. Every other query is run on all
+     * the shards in parallel, the first shard on the calling thread and each other shard on a worker
+     * thread of its own, and the result rows of the shards are merged:
+     * tables are created on every shard, and `findAll()`, `findWhere()` or `fetchColumns()` return the
+     * records of all the shards. Writes to different shards thus proceed concurrently, each shard
+     * having its own writer lock.
+     *
+     * Merged results are not sorted or limited across shards, and aggregates return one row per
+     * shard: the models reject `ORDER BY` and `LIMIT` in their conditions, and `search()` merges
+     * the best matches of the shards by rank. Transactions span every shard but are committed on each shard separately, and
+     * `Transaction::run()` does not retry a busy commit.
+     * Row callbacks of a query run one at a time, on the threads of the shards, and must not
+     * query the sharded database as a whole.
+     */
+    class ShardedDatabase : public IDatabase
+    {
+    public:
+        /**
+         * @brief Constructs a sharded database over disconnected databases, starting the worker threads.
+         *
+         * @param shards The databases holding the shards, at least one.
+         * @throw DatabaseError If no database is given.
+         */
+        ShardedDatabase(const std::vector<std::shared_ptr<IDatabase>> &shards);
+
+        /**
+         * @brief Stops the worker threads.
+         */
+        ~ShardedDatabase();
+
+        /**
+         * @brief Connects every shard to its own file.
+         *
+         * Shard `i` of `data.db` is stored in `data.i.db`. With `:memory:`, each shard is a
+         * separate in-memory database.
+         *
+         * @param url The path of the logical database.
+         * @throw DatabaseError If a connection fails.
+         */
+        void connect(std::string url) override;
+
+        /**
+         * @brief Checks whether every shard is connected.
+         */
+        bool isConnected() override;
+
+        /**
+         * @brief Disconnects every shard.
+         */
+        void disconnect() override;
+
+        /**
+         * @brief Executes a query on every shard in parallel.
+         *
+         * `CREATE ... IF NOT EXISTS` queries run by the models before their first save are only
+         * broadcast once per connection, until a `DROP` or `ALTER` query runs.
+         *
+         * @throw DatabaseError The first failure of a shard, once every shard has finished.
+         */
+        void exec(std::string query, QueryCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a statement on every shard in parallel, merging the result rows.
+         *
+         * @throw DatabaseError The first failure of a shard, once every shard has finished.
+         */
+        void exec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a statement on every shard in parallel, merging the result rows.
+         *
+         * @throw DatabaseError The first failure of a shard, once every shard has finished.
+         */
+        void exec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a query on every shard in parallel, returning the first failure of a shard.
+         */
+        Result<void> tryExec(const std::string &query, QueryCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a statement on every shard in parallel, returning the first failure of a shard.
+         */
+        Result<void> tryExec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Executes a statement on every shard in parallel, returning the first failure of a shard.
+         */
+        Result<void> tryExec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper) override;
+
+        /**
+         * @brief Returns the number of rows changed on every shard by the last statement the calling
+         *        thread ran on the sharded database as a whole.
+         * 
+         * Statements run on a single shard through `shard()` report their changes on that shard.
+         */
+        int64_t changes() override;
+
+        /**
+         * @brief Opens a BLOB on the shard holding its row.
+         *
+         * Models open their BLOBs on their own shard; this tries each shard in turn.
+         *
+         * @throw DatabaseError If no shard holds the BLOB.
+         */
+        std::shared_ptr<IBlob> openBlob(const std::string &table, const std::string &column, int64_t rowid, bool writable) override;
+
+        /**
+         * @brief Installs the observer on every shard.
+         */
+        void setObserver(std::shared_ptr<IQueryObserver> observer) override;
+
+        /**
+         * @brief Enables or disables the query plan analysis on every shard.
+         */
+        void setPlanAnalyzer(plan_callback reporter, bool offendersOnly = true) override;
+
+        /**
+         * @brief Copies every shard to its own file, named like by `connect()`.
+         */
+        void snapshotTo(const std::string &path, int pagesPerStep = 256) override;
+
+        /**
+         * @brief Restores every shard from its own file, named like by `connect()`.
+         */
+        void restoreFrom(const std::string &path, int pagesPerStep = 256) override;
+
+        /**
+         * @brief Brings the columns of a table in line with the fields of a model on every shard, one after the other.
+         *
+         * The progress callback reports the rows of each shard in turn.
+         *
+         * @return The changes made, the added columns being those of any shard.
+         */
+        SchemaChanges evolveTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns,
+                                  const SchemaOptions &options = SchemaOptions()) override;
+
+        /**
+         * @brief Subscribes to the committed changes of a table on every shard.
+         *
+         * Each shard delivers its own batches, on the thread committing to it.
+         */
+        int subscribe(const std::string &table, change_callback cb) override;
+
+        /**
+         * @brief Cancels a subscription on every shard.
+         */
+        void unsubscribe(int subscription) override;
+
+        /**
+         * @brief Returns the memory usage of the engine, summed over the connections of the shards.
+         */
+        MemoryStats memoryStats() override;
+
+        /**
+         * @brief Sets the busy handling policy of every shard.
+         */
+        void setBusyPolicy(const BusyPolicy &policy) override;
+
+        /**
+         * @brief Returns the lock contention counters, summed over the shards.
+         */
+        BusyStats busyStats() override;
+
+        /**
+         * @brief Sets the query timeout of every shard.
+         */
+        void setQueryTimeout(std::chrono::milliseconds timeout) override;
+
+        /**
+         * @brief Interrupts the queries running on every shard.
+         */
+        void interrupt() override;
+
+        /**
+         * @brief Returns the shard holding the rows of a shard key.
+         *
+         * The returned database serializes the calls of concurrent threads.
+         */
+        IDatabase &shard(uint64_t key) override;
+
+        /**
+         * @brief Returns the number of shards.
+         */
+        std::size_t shardCount() const;
+
+        /**
+         * @brief Returns the path of a shard of a logical database, see `connect()`.
+         *
+         * @param url The path of the logical database.
+         * @param index The index of the shard.
+         */
+        static std::string shardUrl(const std::string &url, std::size_t index);
+
+    private:
+        /**
+         * @class Shard
+         * @brief A database of the shards, serializing the calls of concurrent threads.
+         *
+         * A recursive mutex lets row callbacks query their own shard.
+         */
+        class Shard : public IDatabase
+        {
+        public:
+            Shard(std::shared_ptr<IDatabase> db);
+
+            void connect(std::string url) override;
+            bool isConnected() override;
+            void disconnect() override;
+            void exec(std::string query, QueryCallBackWrapper *cb_wrapper) override;
+            void exec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper) override;
+            void exec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper) override;
+            Result<void> tryExec(const std::string &query, QueryCallBackWrapper *cb_wrapper) override;
+            Result<void> tryExec(const std::string &query, const std::vector<FieldInfo> &params, RowCallBackWrapper *cb_wrapper) override;
+            Result<void> tryExec(const std::string &query, const BindCallBackWrapper &binder, RowCallBackWrapper *cb_wrapper) override;
+            int64_t changes() override;
+            std::shared_ptr<IBlob> openBlob(const std::string &table, const std::string &column, int64_t rowid, bool writable) override;
+            void setObserver(std::shared_ptr<IQueryObserver> observer) override;
+            void setPlanAnalyzer(plan_callback reporter, bool offendersOnly = true) override;
+            void snapshotTo(const std::string &path, int pagesPerStep = 256) override;
+            void restoreFrom(const std::string &path, int pagesPerStep = 256) override;
+            SchemaChanges evolveTable(const std::string &table, const std::unordered_map<std::string, FieldInfo> &columns,
+                                      const SchemaOptions &options = SchemaOptions()) override;
+            int subscribe(const std::string &table, change_callback cb) override;
+            void unsubscribe(int subscription) override;
+            MemoryStats memoryStats() override;
+            void setBusyPolicy(const BusyPolicy &policy) override;
+            BusyStats busyStats() override;
+            void setQueryTimeout(std::chrono::milliseconds timeout) override;
+            void interrupt() override;
+            IDatabase &shard(uint64_t key) override;
+
+            /**
+             * @brief Returns the mutex serializing the calls, to run several calls in a row.
+             */
+            std::recursive_mutex &mutex();
+
+        private:
+            std::shared_ptr<IDatabase> _db; ///< The database of the shard.
+            std::recursive_mutex _mutex;    ///< Serializes the calls to the database.
+        };
+
+        /**
+         * @class Worker
+         * @brief A thread running the calls posted to a shard, in order.
+         */
+        class Worker
+        {
+        public:
+            Worker();
+            ~Worker();
+
+            /**
+             * @brief Queues a call.
+             *
+             * @return The future of the call, holding its exception if it throws.
+             */
+            std::future<void> post(std::function<void()> call);
+
+        private:
+            std::mutex _mutex;                                 ///< Protects the queue.
+            std::condition_variable _ready;                    ///< Signaled when a call is queued or the worker stops.
+            std::deque<std::packaged_task<void()>> _queue;     ///< The calls to run.
+            bool _stopping = false;                            ///< Whether the worker must exit once the queue is empty.
+            std::thread _thread;                               ///< The thread running the calls.
+        };
+
+        std::vector<std::unique_ptr<Shard>> _shards;                ///< The shards, in index order.
+        std::vector<std::unique_ptr<Worker>> _workers;              ///< The worker of each shard but the first, which runs on the calling thread.
+        std::mutex _rowMutex;                                       ///< Serializes the callbacks of the queries run on every shard.
+        std::mutex _subscriptionsMutex;                             ///< Protects the subscriptions.
+        std::unordered_map<int, std::vector<int>> _subscriptions;   ///< The subscription of each shard, by logical subscription.
+        int _nextSubscription = 1;                                  ///< The identifier of the next subscription.
+        std::mutex _schemaMutex;                                    ///< Protects the schema queries.
+        std::unordered_set<std::string> _schemaQueries;             ///< The `CREATE ... IF NOT EXISTS` queries already run on every shard.
+
+        /**
+         * @brief Checks whether a query only creates schema objects that were already created.
+         *
+         * Forgets the created objects when the query drops or alters the schema.
+         */
+        bool _alreadyCreated(const std::string &query);
+
+        /**
+         * @brief Forgets the schema queries already run, on connection changes.
+         */
+        void _forgetSchema();
+
+        /**
+         * @brief Runs a call on every shard, one thread per shard, with the query context and deadline of the caller.
+         *
+         * Records the rows changed on every shard by the call, see `changes()`.
+         *
+         * @param call The call, receiving each shard.
+         * @throw DatabaseError The first exception thrown by a shard, once every shard has finished.
+         */
+        void _broadcast(const std::function<void(IDatabase &)> &call);
+
+        /**
+         * @brief Runs a non-throwing call on every shard, see `_broadcast()`.
+         *
+         * @return A success, or the first failure of a shard in index order.
+         */
+        Result<void> _tryBroadcast(const std::function<Result<void>(IDatabase &)> &call);
+
+        /**
+         * @brief Wraps a row callback so that the shards call it one at a time.
+         */
+        std::unique_ptr<RowCallBackWrapper> _serialize(RowCallBackWrapper *cb_wrapper);
+
+        /**
+         * @brief Wraps a query callback so that the shards call it one at a time.
+         */
+        std::unique_ptr<QueryCallBackWrapper> _serialize(QueryCallBackWrapper *cb_wrapper);
+
+        /**
+         * @brief Wraps a binding callback so that the shards call it one at a time.
+         */
+        BindCallBackWrapper _serialize(const BindCallBackWrapper &binder);
+    };
+} // namespace sqlmate
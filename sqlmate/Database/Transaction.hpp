@@ -0,0 +1,126 @@
+/**
+ * @file Transaction.hpp
+ * @brief Defines the RAII transaction guard in the sqlmate namespace.
+ */
+
+#include <memory>
+#include <thread>
+#include "./IDatabase.hpp"
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @class Transaction
+     * @brief Opens a transaction for its lifetime, rolling it back unless it is committed.
+     *
+     * Write transactions start with `BEGIN IMMEDIATE`, taking the write lock upfront so that they
+     * never fail halfway when upgrading a read lock. Read transactions start with `BEGIN DEFERRED`.
+     */
+    class Transaction
+    {
+    public:
+        /**
+         * @brief Begins a transaction.
+         *
+         * @param db The database to run the transaction on.
+         * @param write True for a transaction that writes, false for a read-only one.
+         * @throw BusyError If the write lock cannot be taken within the busy policy's timeout.
+         * @throw DatabaseError If the transaction cannot begin.
+         */
+        Transaction(std::shared_ptr<IDatabase> db, bool write = true) : _db(db), _open(false)
+        {
+            _db->exec(write ? "BEGIN IMMEDIATE;" : "BEGIN DEFERRED;", nullptr);
+            _open = true;
+        }
+
+        /**
+         * @brief Rolls the transaction back if it was neither committed nor rolled back.
+         */
+        ~Transaction()
+        {
+            if (!_open)
+                return;
+            try
+            {
+                _db->exec("ROLLBACK;", nullptr);
+            }
+            catch (const DatabaseError &)
+            {
+                // A failed statement may already have rolled the transaction back
+            }
+        }
+
+        Transaction(Transaction const &) = delete;
+        void operator=(Transaction const &) = delete;
+
+        /**
+         * @brief Commits the transaction.
+         *
+         * If the commit fails, the transaction stays open and is rolled back on destruction.
+         *
+         * @throw BusyError If readers keep the database locked past the busy policy's timeout.
+         * @throw DatabaseError If the commit fails.
+         */
+        void commit()
+        {
+            _db->exec("COMMIT;", nullptr);
+            _open = false;
+        }
+
+        /**
+         * @brief Rolls the transaction back.
+         *
+         * @throw DatabaseError If the rollback fails.
+         */
+        void rollback()
+        {
+            _open = false;
+            _db->exec("ROLLBACK;", nullptr);
+        }
+
+        /**
+         * @brief Runs a function in a transaction, retrying it from the start when the database is busy.
+         *
+         * The function may run several times and should have no side effects outside the database.
+         * A sharded database commits on each shard separately: a busy commit may have gone through on
+         * some shards already, so it is not retried.
+         *
+         * @param db The database to run the transaction on.
+         * @param body The function to run, taking no argument.
+         * @param attempts The maximum number of runs.
+         * @param write True for a transaction that writes, false for a read-only one.
+         * @throw BusyError If the last attempt fails because the database is busy, or if the commit
+         *        of a sharded database fails because a shard is busy.
+         */
+        template <typename F>
+        static void run(std::shared_ptr<IDatabase> db, F body, int attempts = 5, bool write = true)
+        {
+            bool sharded = &db->shard(0) != db.get();
+            for (int attempt = 1;; attempt++)
+            {
+                bool committing = false;
+                try
+                {
+                    Transaction transaction(db, write);
+                    body();
+                    committing = true;
+                    transaction.commit();
+                    return;
+                }
+                catch (const BusyError &)
+                {
+                    if (attempt >= attempts || (committing && sharded))
+                        throw;
+                }
+                // Let the connection holding the lock finish before starting over
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        std::shared_ptr<IDatabase> _db; ///< The database running the transaction.
+        bool _open;                     ///< Whether the transaction is still open.
+    };
+} // namespace sqlmate
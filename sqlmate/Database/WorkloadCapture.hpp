@@ -0,0 +1,213 @@
+/**
+ * @file WorkloadCapture.hpp
+ * @brief Provides a query observer recording the executed statements to a file in the sqlmate namespace.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include "./IQueryObserver.hpp"
+#include "../Exceptions/Database.hpp"
+#include "../Model/BlobStream.hpp"
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @class WorkloadCapture
+     * @brief Query observer writing every executed statement to a file, to be replayed by the `replay` tool.
+     *
+     * Install it with `IDatabase::setObserver()`. The file holds one JSON object per line and
+     * statement, in completion order:
+     *
+     * @code
+     * {"t":1520400,"thread":1,"duration":8300,"rows":0,"changes":1,"sql":"INSERT INTO users (age, name) VALUES (?, ?) ...","params":[24,"Alice"]}
+     * @endcode
+     *
+     * - `t` is the start of the statement, in nanoseconds since the capture started.
+     * - `thread` numbers the threads of the process in order of their first statement.
+     * - `duration` is the run time of the statement, in nanoseconds.
+     * - `params` holds the values bound from a `FieldInfo` vector: integers, reals with a decimal
+     *   point, strings, `null`, `{"blob":"<hex>"}` and `{"zeroblob":<size>}`.
+     * - Statements bound by a callback have no `params`, but an `expanded` text with the values inlined.
+     *
+     * Writes are buffered; the file is flushed by `flush()` and on destruction.
+     */
+    class WorkloadCapture : public IQueryObserver
+    {
+    public:
+        /**
+         * @brief Constructs a `WorkloadCapture` writing to a file, truncated first.
+         *
+         * @param path The path of the capture file.
+         * @throw DatabaseError If the file cannot be opened.
+         */
+        WorkloadCapture(const std::string &path) : _out(path, std::ios::out | std::ios::trunc), _start(std::chrono::steady_clock::now())
+        {
+            if (!_out)
+                throw DatabaseError("[ERR]: unable to open capture file: " + path);
+        }
+
+        /**
+         * @brief Records a completed statement run.
+         */
+        void onQuery(const QueryEvent &event) override
+        {
+            auto started = std::chrono::steady_clock::now() - event.duration;
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            auto thread = _threads.insert({std::this_thread::get_id(), _threads.size() + 1}).first;
+            _line.clear();
+            _line += "{\"t\":" + std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(started - _start).count());
+            _line += ",\"thread\":" + std::to_string(thread->second);
+            _line += ",\"duration\":" + std::to_string(event.duration.count());
+            _line += ",\"rows\":" + std::to_string(event.rowsReturned);
+            _line += ",\"changes\":" + std::to_string(event.rowsChanged);
+            _line += ",\"sql\":";
+            _appendString(event.sql);
+            if (event.params)
+            {
+                _line += ",\"params\":[";
+                for (std::size_t i = 0; i < event.params->size(); i++)
+                {
+                    if (i)
+                        _line += ",";
+                    _appendValue((*event.params)[i]);
+                }
+                _line += "]";
+            }
+            else if (event.expandedSql)
+            {
+                _line += ",\"expanded\":";
+                _appendString(event.expandedSql);
+            }
+            _line += "}\n";
+            _out << _line;
+        }
+
+        /**
+         * @brief Asks for the values bound by callbacks, recorded as `expanded`.
+         */
+        bool wantsExpandedSql() const override { return (true); }
+
+        /**
+         * @brief Writes the buffered statements to the file.
+         */
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _out.flush();
+        }
+
+    private:
+        std::mutex _mutex;                                      ///< Protects the file and the thread numbers.
+        std::ofstream _out;                                     ///< The capture file.
+        std::chrono::steady_clock::time_point _start;           ///< When the capture started.
+        std::unordered_map<std::thread::id, std::size_t> _threads; ///< The number of each thread.
+        std::string _line;                                      ///< The line being written, reused across statements.
+
+        /**
+         * @brief Appends a JSON string.
+         */
+        void _appendString(std::string_view text)
+        {
+            static const char hex[] = "0123456789abcdef";
+
+            _line += '"';
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    _line += '\\';
+                    _line += c;
+                }
+                else if (c == '\n')
+                    _line += "\\n";
+                else if (c == '\t')
+                    _line += "\\t";
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    _line += "\\u00";
+                    _line += hex[(c >> 4) & 0xf];
+                    _line += hex[c & 0xf];
+                }
+                else
+                    _line += c;
+            }
+            _line += '"';
+        }
+
+        /**
+         * @brief Appends a bound value.
+         */
+        void _appendValue(const FieldInfo &field)
+        {
+            bool supported = visitField(field, [&](auto &value)
+                                        {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (is_optional<T>::value)
+                {
+                    if (value)
+                        _appendPlain(*value);
+                    else
+                        _line += "null";
+                }
+                else
+                    _appendPlain(value); });
+            if (!supported)
+                _line += "null";
+        }
+
+        /**
+         * @brief Appends a value that is not optional.
+         */
+        template <typename T>
+        void _appendPlain(const T &value)
+        {
+            static const char hex[] = "0123456789abcdef";
+
+            if constexpr (std::is_same<T, std::string>::value)
+                _appendString(value);
+            else if constexpr (std::is_same<T, std::vector<std::byte>>::value)
+            {
+                _line += "{\"blob\":\"";
+                for (std::byte b : value)
+                {
+                    _line += hex[std::to_integer<int>(b) >> 4];
+                    _line += hex[std::to_integer<int>(b) & 0xf];
+                }
+                _line += "\"}";
+            }
+            else if constexpr (std::is_same<T, BlobStream>::value)
+            {
+                if (value.reserved())
+                    _line += "{\"zeroblob\":" + std::to_string(*value.reserved()) + "}";
+                else
+                    _line += "null";
+            }
+            else if constexpr (std::is_floating_point<T>::value)
+            {
+                if (!std::isfinite(value))
+                {
+                    _line += "null";
+                    return;
+                }
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%.17g", static_cast<double>(value));
+                _line += buffer;
+                // Keeps reals apart from integers when replayed
+                if (std::string_view(buffer).find_first_of(".e") == std::string_view::npos)
+                    _line += ".0";
+            }
+            else
+                _line += std::to_string(static_cast<int64_t>(value));
+        }
+    };
+} // namespace sqlmate
@@ -22,4 +22,42 @@ namespace sqlmate
         std::string _msg;
     };
 
-}
\ No newline at end of file
+    /**
+     * @class BusyError
+     * @brief Thrown when a statement cannot get a lock held by another connection.
+     * 
+     * The transaction that raised it should be rolled back and retried.
+     */
+    class BusyError : public DatabaseError
+    {
+    public:
+        BusyError(const std::string &message) : DatabaseError(message)
+        {
+        }
+    };
+
+    /**
+     * @class QueryTimeoutError
+     * @brief Thrown when a query is interrupted because it ran past its deadline.
+     */
+    class QueryTimeoutError : public DatabaseError
+    {
+    public:
+        QueryTimeoutError(const std::string &message) : DatabaseError(message)
+        {
+        }
+    };
+
+    /**
+     * @class QueryCancelledError
+     * @brief Thrown when a query is interrupted by a cancellation token or `IDatabase::interrupt()`.
+     */
+    class QueryCancelledError : public DatabaseError
+    {
+    public:
+        QueryCancelledError(const std::string &message) : DatabaseError(message)
+        {
+        }
+    };
+
+}
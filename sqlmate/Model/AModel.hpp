@@ -5,14 +5,28 @@
  */
 
 #include "../Database/IDatabase.hpp"
+#include "../QueryBuilder/StaticQueryBuilder.hpp"
 #include "./IModel.hpp"
 #include "./decorators.hpp"
+#include "./Relation.hpp"
+#include "./ColumnBuffer.hpp"
+#include "./BulkIO.hpp"
+#include "../Database/Transaction.hpp"
 
 #include <cxxabi.h>
+#include <array>
+#include <tuple>
 #include <typeinfo>
 #include <typeindex>
 #include <unordered_map>
 #include <functional>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <sstream>
+#include <map>
+#include <mutex>
+#include <set>
 
 #pragma once
 
@@ -59,16 +73,25 @@ namespace sqlmate
          * @brief Saves the current model instance to the database.
          * 
          * If the table does not exist, it is created. The model's fields are then inserted
-         * into the table.
+         * into the table, or updated if a record with the same `_id` exists.
+         * `BlobStream` fields are written as a zero-filled BLOB if `reserve()` was called,
+         * and keep their stored content otherwise.
          * 
          * @throw DatabaseError If the save operation fails.
          */
         void save() override
         {
-            _createTableIfNotExists();
+            _save<true>();
+        }
 
-            std::string query = _db->qbuilder->insertQuery(getTableName(), fields);
-            _db->exec(query, nullptr);
+        /**
+         * @brief Saves the current model instance to the database, returning failures instead of throwing them.
+         * 
+         * @return A success, or the error of the database.
+         */
+        Result<void> trySave() override
+        {
+            return (_save<false>());
         }
 
         /**
@@ -81,55 +104,479 @@ namespace sqlmate
          */
         void remove() override
         {
-            _createTableIfNotExists();
+            _remove<true>();
+        }
 
-            std::string query = _db->qbuilder->deleteQuery(getTableName(), _id);
-            _db->exec(query, nullptr);
+        /**
+         * @brief Removes the current model instance from the database, returning failures instead of throwing them.
+         * 
+         * @return A success, or the error of the database.
+         */
+        Result<void> tryRemove() override
+        {
+            return (_remove<false>());
         }
 
         template <typename T>
-        std::shared_ptr<T> findOne(int id)
+        std::shared_ptr<T> findOne(int id, const char *file = __builtin_FILE(), int line = __builtin_LINE())
         {
+            return (*_findOne<T, true>(id, file, line));
+        }
 
+        /**
+         * @brief Retrieves a record by `_id`, returning failures instead of throwing them.
+         * 
+         * @tparam T The model type to instantiate.
+         * @param id The `_id` of the record.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return The loaded model, `nullptr` if no record matches, or the error of the database.
+         */
+        template <typename T>
+        Result<std::shared_ptr<T>> tryFindOne(int id, const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            return (_findOne<T, false>(id, file, line));
+        }
+
+        /**
+         * @brief Retrieves every record of the table.
+         * 
+         * @tparam T The model type to instantiate for each record.
+         * @param include The names of the relations to eagerly load on the returned models.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return A vector of shared pointers to the loaded models.
+         * @throw DatabaseError If the query fails.
+         * @throw ModelError If a relation in `include` is not declared.
+         */
+        template <typename T>
+        std::vector<std::shared_ptr<T>> findAll(const std::vector<std::string> &include = {},
+                                                const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            return (findWhere<T>("", include, file, line));
+        }
+
+        /**
+         * @brief Retrieves the records of the table matching a condition.
+         * 
+         * Each relation listed in `include` is loaded for all the returned models at once,
+         * with one `IN (...)` query per chunk of models instead of one query per model.
+         * 
+         * @tparam T The model type to instantiate for each record.
+         * @param condition The SQL condition filtering the records, or an empty string for all records.
+         * @param include The names of the relations to eagerly load on the returned models.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return A vector of shared pointers to the loaded models.
+         * @throw DatabaseError If the query fails.
+         * @throw ModelError If a relation in `include` is not declared, or if the database is sharded
+         *        and the condition holds `ORDER BY` or `LIMIT`.
+         */
+        template <typename T>
+        std::vector<std::shared_ptr<T>> findWhere(const std::string &condition, const std::vector<std::string> &include = {},
+                                                  const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            std::vector<std::shared_ptr<T>> models = std::move(*_findWhere<T, true>(condition, {}, file, line));
+
+            if (!models.empty() && !include.empty())
+            {
+                std::vector<AModel *> parents;
+                parents.reserve(models.size());
+                for (auto &model : models)
+                    parents.push_back(model.get());
+                for (const auto &name : include)
+                {
+                    auto relation = models.front()->relations.find(name);
+                    if (relation == models.front()->relations.end())
+                        throw ModelError("Unknown relation :" + name);
+                    relation->second.load(parents);
+                }
+            }
+            return (models);
+        }
+
+        /**
+         * @brief Retrieves the records of the table matching a condition, returning failures instead of throwing them.
+         * 
+         * Relations are not loaded, see `findWhere()`.
+         * 
+         * @tparam T The model type to instantiate for each record.
+         * @param condition The SQL condition filtering the records, or an empty string for all records.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return A vector of shared pointers to the loaded models, or the error of the database.
+         * @throw ModelError If the database is sharded and the condition holds `ORDER BY` or `LIMIT`.
+         */
+        template <typename T>
+        Result<std::vector<std::shared_ptr<T>>> tryFindWhere(const std::string &condition,
+                                                             const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            return (_findWhere<T, false>(condition, {}, file, line));
+        }
+
+        /**
+         * @brief Retrieves columns of the records matching a condition into contiguous typed buffers.
+         * 
+         * Rows are decoded straight into one `ColumnBuffer` per member, without constructing models:
+         * numeric members into a `std::vector` of their type, text and BLOB members into a single
+         * arena with offsets, and optional members with a validity mask.
+         * 
+         * @code
+         * auto [ages, scores] = user.fetchColumns<User>("age > 18", &User::age, &User::score);
+         * @endcode
+         * 
+         * @tparam T The model type declaring the members.
+         * @param condition The SQL condition filtering the records, or an empty string for all records.
+         * @param members Pointers to the fields to fetch, in the order of the returned buffers.
+         * @return The buffers of the fetched columns, each holding one value per record.
+         * @throw DatabaseError If the query fails.
+         * @throw ModelError If a member is not a field of the model, or if the database is sharded and
+         *        the condition holds `ORDER BY` or `LIMIT`.
+         */
+        template <typename T, typename... Members>
+        std::tuple<ColumnBuffer<typename member_type<Members>::type>...> fetchColumns(const std::string &condition, Members... members)
+        {
             static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
-            std::shared_ptr<T> model = nullptr;
-            std::string query = _db->qbuilder->selectQuery(getTableName(), "_id == " + std::to_string(id), 1);
+            static_assert(sizeof...(Members) > 0, "at least one column must be fetched");
+            _checkShardedCondition(condition);
+            QueryContextScope scope(typeid(T));
 
-            QueryCallBackWrapper cb([&](int argc, char **argv, char **azColName) -> int
-                                    {
-                        model = std::make_shared<T>(_db);
-                        for (int i = 0; i < argc; i++) {
-                            // std::cout << i << std::endl;
-                            // std::cout << azColName[i] << " = " << (argv[i] ? argv[i] : "NULL") << std::endl;
-                            if (argv[i])
-                                model->updateField(azColName[i], argv[i]);
+            T probe(_db);
+            std::array<std::string, sizeof...(Members)> names = {probe._columnOf(&(probe.*members))...};
+            std::unordered_map<std::string, FieldInfo> columns;
+            for (const auto &name : names)
+                columns.insert({name, probe.fields.at(name)});
+
+            std::tuple<ColumnBuffer<typename member_type<Members>::type>...> buffers;
+            std::array<int, sizeof...(Members)> positions;
+            bool resolved = false;
+            RowCallBackWrapper cb([&](IRow &row) -> int
+                                  {
+                        if (!resolved)
+                        {
+                            for (std::size_t i = 0; i < names.size(); i++)
+                                for (int col = 0; col < row.columnCount(); col++)
+                                    if (names[i] == row.columnName(col))
+                                        positions[i] = col;
+                            resolved = true;
                         }
+                        _appendColumns(buffers, row, positions, std::index_sequence_for<Members...>{});
                         return 0; });
-            _db->exec(query, &cb);
-            return (model);
+            _db->exec(_db->qbuilder->selectQuery(probe.getTableName(), columns, condition), std::vector<FieldInfo>(), &cb);
+            return (buffers);
         }
 
+        /**
+         * @brief Deletes the records of the table matching a condition, with a single statement.
+         * 
+         * No model is loaded. Full-text indexes and change subscriptions see the deleted rows.
+         * 
+         * @code
+         * int64_t expired = session.removeWhere<Session>("expires < ?", {sqlmate::FieldInfo::of(now)});
+         * @endcode
+         * 
+         * @tparam T The model type of the records.
+         * @param condition The SQL condition selecting the records, with `?` placeholders, or an empty
+         *        string for all records.
+         * @param params The values bound to the placeholders of `condition`, in order.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return The number of deleted records.
+         * @throw DatabaseError If the query fails.
+         */
         template <typename T>
-        std::vector<std::shared_ptr<T>> findAll()
+        int64_t removeWhere(const std::string &condition, const std::vector<FieldInfo> &params = {},
+                            const char *file = __builtin_FILE(), int line = __builtin_LINE())
         {
             static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
-            std::vector<std::shared_ptr<T>> models;
-            std::string query = _db->qbuilder->selectQuery(getTableName());
+            QueryContextScope scope(typeid(T), file, line);
 
-            QueryCallBackWrapper cb([&](int argc, char **argv, char **azColName) -> int
-                                    {
-                        models.push_back(std::make_shared<T>(_db));
-                        for (int i = 0; i < argc; i++) {
-                            // std::cout << i << std::endl;
-                            // std::cout << azColName[i] << " = " << (argv[i] ? argv[i] : "NULL") << std::endl;
-                            if (argv[i])
-                                models.back()->updateField(azColName[i], argv[i]);
+            T probe(_db);
+            _createTableOf(probe);
+            _db->exec(_db->qbuilder->deleteWhereQuery(probe.getTableName(), condition), params, nullptr);
+            return (_db->changes());
+        }
+
+        /**
+         * @brief Sets fields of the records of the table matching a condition, with a single statement.
+         * 
+         * No model is loaded: models already loaded keep their previous values until reloaded.
+         * On a sharded database, the shard key cannot be updated, since rows would not move to
+         * their new shard.
+         * 
+         * @code
+         * user.updateWhere<User>("last_seen < ?", {{"active", sqlmate::FieldInfo::of(false)}},
+         *                        {sqlmate::FieldInfo::of(cutoff)});
+         * @endcode
+         * 
+         * @tparam T The model type of the records.
+         * @param condition The SQL condition selecting the records, with `?` placeholders, or an empty
+         *        string for all records.
+         * @param assignments A map of the updated column names to their new values.
+         * @param params The values bound to the placeholders of `condition`, in order.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return The number of updated records.
+         * @throw ModelError If there is no assignment, or an assigned column is not a field of the
+         *        model or is its shard key.
+         * @throw DatabaseError If the query fails.
+         */
+        template <typename T>
+        int64_t updateWhere(const std::string &condition, const std::unordered_map<std::string, FieldInfo> &assignments,
+                            const std::vector<FieldInfo> &params = {},
+                            const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
+            QueryContextScope scope(typeid(T), file, line);
+
+            T probe(_db);
+            if (assignments.empty())
+                throw ModelError("No column to update on :" + probe.getTableName());
+            bool sharded = (&_db->shard(0) != _db.get());
+            std::string shardKey = (probe._shardKey.empty() ? "_id" : probe._shardKey);
+            for (const auto &[columnName, value] : assignments)
+            {
+                if (probe.fields.find(columnName) == probe.fields.end())
+                    throw ModelError("Unknown column :" + columnName);
+                if (sharded && columnName == shardKey)
+                    throw ModelError("Cannot update the shard key :" + columnName);
+            }
+            _createTableOf(probe);
+
+            // The assigned values come first, in the iteration order the query is built in
+            std::vector<FieldInfo> bound;
+            bound.reserve(assignments.size() + params.size());
+            for (const auto &[columnName, value] : assignments)
+                bound.push_back(value);
+            bound.insert(bound.end(), params.begin(), params.end());
+            _db->exec(_db->qbuilder->updateWhereQuery(probe.getTableName(), assignments, condition), bound, nullptr);
+            return (_db->changes());
+        }
+
+        /**
+         * @brief Brings the table of a model in line with its fields, rebuilding it if needed.
+         * 
+         * Tables gain the columns added to their model when first used; this also rebuilds tables
+         * whose column types or `_id` key differ from the model, see `IDatabase::evolveTable()`. Run
+         * it once at deployment, outside of any transaction.
+         * 
+         * @code
+         * sqlmate::SchemaOptions options;
+         * options.progress = [](const sqlmate::SchemaProgress &p) { std::cout << p.rowsCopied << "/" << p.rowsTotal << "\n"; };
+         * user.migrate<User>(options);
+         * @endcode
+         * 
+         * @tparam T The model type of the table.
+         * @param options Whether and how the table may be rebuilt.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return The changes made to the table.
+         * @throw DatabaseError If a change fails, the table being left as it was.
+         */
+        template <typename T>
+        SchemaChanges migrate(const SchemaOptions &options = SchemaOptions(),
+                              const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
+            QueryContextScope scope(typeid(T), file, line);
+
+            T probe(_db);
+            _createTableOf(probe);
+            return (_db->evolveTable(probe.getTableName(), probe.fields, options));
+        }
+
+        /**
+         * @brief Inserts the records of a CSV or NDJSON stream into the table, without a model per record.
+         * 
+         * The stream is parsed in chunks into a single reused model, inserted with the same prepared
+         * statement, `ImportOptions::batchSize` records per transaction. Values are matched to the
+         * fields by column name: CSV streams start with a header line, NDJSON records are objects.
+         * Missing values, and NULL values of non-optional fields, take the default value of the field.
+         * Records with an `_id` replace the row with the same `_id`, like `save()`; the others get a
+         * new `_id`, except on sharded databases, where every record needs one since each shard numbers
+         * its own rows. `BlobStream` fields cannot be imported.
+         * 
+         * With `ImportOptions::deferIndexes`, the non-unique indexes of the table are dropped before the
+         * import and recreated after it, even if it fails; unique indexes are kept to reject duplicates.
+         * A failed import keeps the batches already committed.
+         * 
+         * @code
+         * std::ifstream file("users.csv");
+         * user.importStream<User>(file, sqlmate::CSV);
+         * @endcode
+         * 
+         * @tparam T The model type of the records.
+         * @param in The stream to read.
+         * @param format The format of the stream.
+         * @param options How the records are written.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return The number of imported records.
+         * @throw ModelError If a record is malformed, names an unknown column, holds an invalid value,
+         *        or has no `_id` on a sharded database.
+         * @throw DatabaseError If an insertion fails, or a deferred index cannot be recreated.
+         */
+        template <typename T>
+        int64_t importStream(std::istream &in, DataFormat format, const ImportOptions &options = ImportOptions(),
+                             const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
+            QueryContextScope scope(typeid(T), file, line);
+
+            T model(_db);
+            _createTableOf(model);
+
+            std::vector<std::string> indexes;
+            if (options.deferIndexes)
+                indexes = _dropIndexes(model.getTableName());
+            int64_t count = 0;
+            try
+            {
+                count = _importRecords<T>(model, in, format, options);
+            }
+            catch (const std::exception &error)
+            {
+                std::string failures = _recreateIndexes(indexes);
+                if (!failures.empty())
+                    throw DatabaseError(std::string(error.what()) + ", and " + failures);
+                throw;
+            }
+            std::string failures = _recreateIndexes(indexes);
+            if (!failures.empty())
+                throw DatabaseError(failures);
+            return (count);
+        }
+
+        /**
+         * @brief Writes the records matching a condition to a CSV or NDJSON stream, without a model per record.
+         * 
+         * Rows are written as the query steps through them, so the table is never held in memory.
+         * Fields are written `_id` first, then by column name; `BlobStream` fields are left out.
+         * Text is written as is, BLOBs as hexadecimal text. The output reads back with `importStream()`.
+         * 
+         * @code
+         * std::ofstream file("adults.ndjson");
+         * user.exportStream<User>(file, sqlmate::NDJSON, "age >= 18");
+         * @endcode
+         * 
+         * @tparam T The model type of the records.
+         * @param out The stream to write.
+         * @param format The format of the stream.
+         * @param condition The SQL condition filtering the records, or an empty string for all records.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return The number of exported records.
+         * @throw DatabaseError If the query fails.
+         * @throw ModelError If the database is sharded and the condition holds `ORDER BY` or `LIMIT`.
+         */
+        template <typename T>
+        int64_t exportStream(std::ostream &out, DataFormat format, const std::string &condition = "",
+                             const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
+            _checkShardedCondition(condition);
+            QueryContextScope scope(typeid(T), file, line);
+
+            T probe(_db);
+            std::unordered_map<std::string, FieldInfo> columns;
+            std::vector<std::string> names;
+            for (const auto &[columnName, field] : probe.fields)
+                if (field.typeId != typeid(BlobStream))
+                {
+                    columns.insert({columnName, field});
+                    names.push_back(columnName);
+                }
+            // `_id` first, then the other columns by name, as a strict weak ordering
+            std::sort(names.begin(), names.end(), [](const std::string &a, const std::string &b)
+                      { return (a != b && (a == "_id" || (b != "_id" && a < b))); });
+            std::vector<ValueKind> kinds;
+            for (const auto &name : names)
+                visitField(columns.at(name), [&](auto &value)
+                           { kinds.push_back(valueKind<std::decay_t<decltype(value)>>()); });
+
+            RecordWriter writer(out, format, names);
+            std::vector<int> positions(names.size());
+            bool resolved = false;
+            int64_t count = 0;
+            RowCallBackWrapper cb([&](IRow &row) -> int
+                                  {
+                        if (!resolved)
+                        {
+                            for (std::size_t i = 0; i < names.size(); i++)
+                                for (int col = 0; col < row.columnCount(); col++)
+                                    if (names[i] == row.columnName(col))
+                                        positions[i] = col;
+                            resolved = true;
                         }
+                        writer.write(row, positions, kinds);
+                        count++;
                         return 0; });
-            _db->exec(query, &cb);
+            _db->exec(_db->qbuilder->selectQuery(probe.getTableName(), columns, condition), std::vector<FieldInfo>(), &cb);
+            writer.flush();
+            return (count);
+        }
+
+        /**
+         * @brief Retrieves the records matching a full-text query, best match first.
+         * 
+         * The query uses the database's full-text syntax, such as `"sqlite AND (orm OR database)"`
+         * or `"prefix*"`, and is matched against the columns declared with `FULLTEXT`.
+         * 
+         * @tparam T The model type to instantiate for each record.
+         * @param query The full-text query.
+         * @param limit The maximum number of records to return.
+         * @param file The source file of the call site, reported by query diagnostics.
+         * @param line The source line of the call site, reported by query diagnostics.
+         * @return A vector of shared pointers to the loaded models, by decreasing relevance.
+         * @throw DatabaseError If the query fails or is malformed.
+         * @throw ModelError If the model has no full-text indexed column.
+         */
+        template <typename T>
+        std::vector<std::shared_ptr<T>> search(const std::string &query, int limit = 20,
+                                               const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        {
+            static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
+            if (_fullTextColumns.empty())
+                throw ModelError("No full-text indexed column on :" + getTableName());
+            QueryContextScope scope(typeid(T), file, line);
+            _createTableIfNotExists();
+
+            std::vector<std::pair<double, std::shared_ptr<T>>> ranked;
+            std::string text = query;
+            RowCallBackWrapper cb([&](IRow &row) -> int
+                                  {
+                        ranked.push_back({0, std::make_shared<T>(_db)});
+                        for (int i = 0; i < row.columnCount(); i++)
+                        {
+                            if (std::string(row.columnName(i)) == "_rank")
+                                ranked.back().first = row.getDouble(i);
+                            else
+                                ranked.back().second->updateField(row.columnName(i), row, i);
+                        }
+                        return 0; });
+            _db->exec(_db->qbuilder->searchQuery(getTableName(), fields),
+                      {FieldInfo(std::ref(text), typeid(std::string)), FieldInfo(std::ref(limit), typeid(int))}, &cb);
+
+            // A sharded database returns the best matches of each shard one after another
+            std::stable_sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b)
+                             { return (a.first < b.first); });
+            std::vector<std::shared_ptr<T>> models;
+            for (std::size_t i = 0; i < ranked.size() && i < static_cast<std::size_t>(std::max(limit, 0)); i++)
+                models.push_back(ranked[i].second);
             return (models);
         }
 
+        /**
+         * @brief Subscribes to the committed changes of this model's table.
+         * 
+         * @param cb The callback receiving the batches of changes, see `IDatabase::subscribe()`.
+         * @return The identifier of the subscription, to pass to `IDatabase::unsubscribe()`.
+         */
+        int subscribe(change_callback cb)
+        {
+            return (_db->subscribe(getTableName(), cb));
+        }
+
         int getId()
         {
             return (_id);
@@ -137,70 +584,973 @@ namespace sqlmate
 
     protected:
         std::unordered_map<std::string, FieldInfo> fields;
+        std::unordered_map<std::string, RelationInfo> relations;
+        std::vector<std::string> _fullTextColumns; ///< Columns of the full-text index, see `FULLTEXT`.
+        std::string _shardKey;                     ///< Column routing the rows to a shard, `_id` if empty, see `SHARD_KEY`.
         std::shared_ptr<IDatabase> _db;
         bool _tableCreated;
         int _id;
+        LiveModelCounter _liveCounter; ///< Counts this instance in `MemoryStats::liveModels`.
         static int nextID;
+        static constexpr std::size_t _relationChunkSize = 500; ///< Maximum number of keys per `IN (...)` list.
+
+        /**
+         * @brief Runs a query with `exec()` or `tryExec()`.
+         * 
+         * @tparam Throw Whether failures are thrown, or returned.
+         * @param db The database running the query, `*_db` or the shard of this model.
+         * @param query The SQL query.
+         * @param args The remaining arguments of `exec()`.
+         * @return A success, or the error of the database if `Throw` is false.
+         * @throw DatabaseError If the query fails and `Throw` is true.
+         */
+        template <bool Throw, typename... Args>
+        static Result<void> _execute(IDatabase &db, const std::string &query, Args &&...args)
+        {
+            if constexpr (Throw)
+            {
+                db.exec(query, std::forward<Args>(args)...);
+                return (Result<void>());
+            }
+            else
+                return (db.tryExec(query, std::forward<Args>(args)...));
+        }
 
         /**
          * @brief Ensures the table exists by creating it if it does not already exist.
          * 
          * This method is called before performing operations like saving or removing records.
          * 
-         * @throw DatabaseError If the table creation query fails.
+         * @tparam Throw Whether database failures are thrown, or returned.
+         * @throw DatabaseError If the table creation query fails and `Throw` is true.
          */
-        void _createTableIfNotExists()
+        template <bool Throw = true>
+        Result<void> _createTableIfNotExists()
         {
             if (!_tableCreated)
             {
                 std::string query = _db->qbuilder->createTableQuery(getTableName(), fields);
 
-                _db->exec(query, nullptr);
+                Result<void> result = _execute<Throw>(*_db, query, nullptr);
+                if (result)
+                    result = _addMissingColumns<Throw>();
+                if (result)
+                    result = _createFullTextIndex<Throw>();
+                if (!result)
+                    return (result);
                 _tableCreated = true;
             }
+            return (Result<void>());
         }
 
-        template <typename T>
-        void _parseStr(std::string str, T &value)
+        /**
+         * @brief Adds the columns of the model missing from its table, once per process, database and model type.
+         * 
+         * Tables whose column types changed are left as they are, see `migrate()`. The databases
+         * destroyed since are forgotten whenever a table is evolved.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned, with the kind of the failure.
+         * @throw DatabaseError If a column cannot be added and `Throw` is true.
+         */
+        template <bool Throw = true>
+        Result<void> _addMissingColumns()
         {
-            std::stringstream stream(str);
+            static std::mutex mutex;
+            static std::map<std::weak_ptr<IDatabase>, std::set<std::string>, std::owner_less<std::weak_ptr<IDatabase>>> evolved;
 
-            if constexpr (std::is_same<T, bool>::value)
-                stream >> std::boolalpha >> value;
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string key = std::string(typeid(*this).name()) + ":" + getTableName();
+            auto found = evolved.find(_db);
+            if (found != evolved.end() && found->second.count(key))
+                return (Result<void>());
+            for (auto it = evolved.begin(); it != evolved.end();)
+                it = (it->first.expired() ? evolved.erase(it) : std::next(it));
+
+            SchemaOptions options;
+            options.rebuild = false;
+            if constexpr (Throw)
+                _db->evolveTable(getTableName(), fields, options);
             else
-                stream >> value;
-            if (stream.fail())
-                throw ModelError("Error parsing value :" + str);
+            {
+                try
+                {
+                    _db->evolveTable(getTableName(), fields, options);
+                }
+                catch (const DatabaseError &e)
+                {
+                    return (Result<void>(Error::of(e, "unable to add the missing columns")));
+                }
+            }
+            evolved[_db].insert(key);
+            return (Result<void>());
         }
 
-        void updateField(const std::string &key, const std::string &input)
+        /**
+         * @brief Creates the full-text index of the table if the model declares one, see `FULLTEXT`.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned.
+         * @throw ModelError If an indexed column is not a text field.
+         * @throw DatabaseError If the index creation fails and `Throw` is true.
+         */
+        template <bool Throw = true>
+        Result<void> _createFullTextIndex()
         {
+            if (_fullTextColumns.empty())
+                return (Result<void>());
+            for (const auto &column : _fullTextColumns)
+            {
+                auto field = fields.find(column);
+                if (field == fields.end() || (field->second.typeId != typeid(std::string) &&
+                                              field->second.typeId != typeid(std::optional<std::string>)))
+                    throw ModelError("Full-text indexed column is not a text field :" + column);
+            }
+            return (_execute<Throw>(*_db, _db->qbuilder->createFullTextQuery(getTableName(), _fullTextColumns), nullptr));
+        }
 
-            if (fields.find(key) == fields.end())
-                throw ModelError("Error parsing key :" + key);
+        /**
+         * @brief Saves the current model instance, see `save()`.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned.
+         */
+        template <bool Throw>
+        Result<void> _save()
+        {
+            QueryContextScope scope(typeid(*this));
+            Result<void> result = _createTableIfNotExists<Throw>();
+            if (!result)
+                return (result);
+
+            std::string query = _db->qbuilder->insertQuery(getTableName(), fields);
+            std::vector<FieldInfo> params;
+            std::vector<BlobStream *> streams;
+            params.reserve(fields.size());
+            for (const auto &[columnName, field] : fields)
+            {
+                params.push_back(field);
+                if (field.typeId == typeid(BlobStream))
+                    streams.push_back(&_attachBlobStream(columnName, field));
+            }
+            result = _execute<Throw>(_shardDb(), query, params, nullptr);
+            if (result)
+                _settleBlobStreams(streams);
+            return (result);
+        }
+
+        /**
+         * @brief Removes the current model instance, see `remove()`.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned.
+         */
+        template <bool Throw>
+        Result<void> _remove()
+        {
+            QueryContextScope scope(typeid(*this));
+            Result<void> result = _createTableIfNotExists<Throw>();
+            if (!result)
+                return (result);
+
+            std::string query = _db->qbuilder->deleteQuery(getTableName(), _id);
+            return (_execute<Throw>(_shardDb(), query, nullptr));
+        }
+
+        /**
+         * @brief Retrieves a record by `_id`, see `findOne()`.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned.
+         */
+        template <typename T, bool Throw>
+        Result<std::shared_ptr<T>> _findOne(int id, const char *file, int line)
+        {
+            static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
+            QueryContextScope scope(typeid(T), file, line);
+            std::shared_ptr<T> model = nullptr;
+            Result<void> result;
+            IDatabase &db = (_shardKey.empty() ? _db->shard(static_cast<uint64_t>(id)) : *_db);
+            if constexpr (has_schema<T>::value)
+            {
+                using Q = StaticQueryBuilder<T>;
+                BindCallBackWrapper binder([&](IParams &params)
+                                           { params.bindInt64(1, id); });
+                RowCallBackWrapper cb([&](IRow &row) -> int
+                                      {
+                        model = std::make_shared<T>(_db);
+                        _decodeStatic(*model, row);
+                        return 0; });
+                result = _execute<Throw>(db, Q::template query<Q::selectOneSQL>(), binder, &cb);
+            }
+            else
+            {
+                std::string query = _db->qbuilder->selectQuery(getTableName(), fields, "_id = ?", 1);
+
+                RowCallBackWrapper cb([&](IRow &row) -> int
+                                      {
+                        model = std::make_shared<T>(_db);
+                        for (int i = 0; i < row.columnCount(); i++)
+                            model->updateField(row.columnName(i), row, i);
+                        return 0; });
+                result = _execute<Throw>(db, query, std::vector<FieldInfo>{FieldInfo(std::ref(id), typeid(int))}, &cb);
+            }
+            if (!result)
+                return (result.error());
+            return (model);
+        }
+
+        /**
+         * @brief Retrieves the records of the table matching a condition, without loading relations, see `findWhere()`.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned.
+         * @param params The values bound to the placeholders of `condition`, in order.
+         */
+        template <typename T, bool Throw>
+        Result<std::vector<std::shared_ptr<T>>> _findWhere(const std::string &condition, const std::vector<FieldInfo> &params,
+                                                           const char *file, int line)
+        {
+            static_assert(std::is_base_of<AModel, T>::value, "type parameter of this class must derive from AModel");
+            _checkShardedCondition(condition);
+            QueryContextScope scope(typeid(T), file, line);
+            std::vector<std::shared_ptr<T>> models;
+            Result<void> result;
+            if constexpr (has_schema<T>::value)
+            {
+                std::string query(StaticQueryBuilder<T>::selectSQL.view());
+                if (!condition.empty())
+                    query += " WHERE " + condition;
+                query += ";";
+
+                RowCallBackWrapper cb([&](IRow &row) -> int
+                                      {
+                        models.push_back(std::make_shared<T>(_db));
+                        _decodeStatic(*models.back(), row);
+                        return 0; });
+                result = _execute<Throw>(*_db, query, params, &cb);
+            }
+            else
+            {
+                std::string query = _db->qbuilder->selectQuery(getTableName(), fields, condition);
+
+                RowCallBackWrapper cb([&](IRow &row) -> int
+                                      {
+                        models.push_back(std::make_shared<T>(_db));
+                        for (int i = 0; i < row.columnCount(); i++)
+                            models.back()->updateField(row.columnName(i), row, i);
+                        return 0; });
+                result = _execute<Throw>(*_db, query, params, &cb);
+            }
+            if (!result)
+                return (result.error());
+            return (models);
+        }
+
+        /**
+         * @brief Settles the size of the `BlobStream` fields written by a save.
+         * 
+         * @param streams The `BlobStream` fields of the model.
+         */
+        static void _settleBlobStreams(const std::vector<BlobStream *> &streams)
+        {
+            for (BlobStream *stream : streams)
+            {
+                if (stream->_reserved)
+                    stream->_size = *stream->_reserved;
+                stream->_reserved.reset();
+            }
+        }
+
+        /**
+         * @brief Registers a one-to-many relationship, see `HAS_MANY`.
+         * 
+         * @tparam Child The related model type.
+         * @param name The name of the relation.
+         * @param member The member receiving the related models.
+         * @param foreignKey The name of the field of `Child` referencing this model.
+         */
+        template <typename Child>
+        void _hasMany(const std::string &name, std::vector<std::shared_ptr<Child>> &member, const std::string &foreignKey)
+        {
+            static_assert(std::is_base_of<AModel, Child>::value, "related model must derive from AModel");
+            relations.insert({name, RelationInfo(ONE_TO_MANY, foreignKey, std::ref(member),
+                                                 [name, foreignKey](const std::vector<AModel *> &parents)
+                                                 {
+                                                     std::unordered_map<int64_t, std::vector<std::shared_ptr<Child>> *> targets;
+                                                     std::vector<int64_t> keys;
+                                                     for (AModel *parent : parents)
+                                                     {
+                                                         auto &children = std::any_cast<std::reference_wrapper<std::vector<std::shared_ptr<Child>>>>(parent->relations.at(name).target).get();
+                                                         children.clear();
+                                                         if (targets.insert({parent->_id, &children}).second)
+                                                             keys.push_back(parent->_id);
+                                                     }
+
+                                                     Child probe(parents.front()->_db);
+                                                     for (std::size_t i = 0; i < keys.size(); i += _relationChunkSize)
+                                                     {
+                                                         auto found = probe.template _findWhere<Child, true>(_inCondition(foreignKey), {FieldInfo::of(_inKeys(keys, i))},
+                                                                                                             QueryContext::current().file, QueryContext::current().line);
+                                                         for (auto &child : *found)
+                                                         {
+                                                             auto target = targets.find(child->_integerField(foreignKey));
+                                                             if (target != targets.end())
+                                                                 target->second->push_back(child);
+                                                         }
+                                                     }
+                                                 })});
+        }
+
+        /**
+         * @brief Registers a many-to-one relationship, see `BELONGS_TO`.
+         * 
+         * @tparam Parent The related model type.
+         * @param name The name of the relation.
+         * @param member The member receiving the related model.
+         * @param foreignKey The name of the field of this model referencing `Parent`.
+         */
+        template <typename Parent>
+        void _belongsTo(const std::string &name, std::shared_ptr<Parent> &member, const std::string &foreignKey)
+        {
+            static_assert(std::is_base_of<AModel, Parent>::value, "related model must derive from AModel");
+            relations.insert({name, RelationInfo(MANY_TO_ONE, foreignKey, std::ref(member),
+                                                 [name, foreignKey](const std::vector<AModel *> &children)
+                                                 {
+                                                     std::vector<int64_t> keys;
+                                                     for (AModel *child : children)
+                                                         keys.push_back(child->_integerField(foreignKey));
+                                                     std::sort(keys.begin(), keys.end());
+                                                     keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+                                                     std::unordered_map<int64_t, std::shared_ptr<Parent>> parents;
+                                                     Parent probe(children.front()->_db);
+                                                     for (std::size_t i = 0; i < keys.size(); i += _relationChunkSize)
+                                                     {
+                                                         auto found = probe.template _findWhere<Parent, true>(_inCondition("_id"), {FieldInfo::of(_inKeys(keys, i))},
+                                                                                                              QueryContext::current().file, QueryContext::current().line);
+                                                         for (auto &parent : *found)
+                                                             parents.insert({parent->getId(), parent});
+                                                     }
+
+                                                     for (AModel *child : children)
+                                                     {
+                                                         auto &target = std::any_cast<std::reference_wrapper<std::shared_ptr<Parent>>>(child->relations.at(name).target).get();
+                                                         auto parent = parents.find(child->_integerField(foreignKey));
+                                                         target = (parent != parents.end()) ? parent->second : nullptr;
+                                                     }
+                                                 })});
+        }
+
+        /**
+         * @brief Builds a `column IN (...)` condition matching the keys bound as a JSON array, see `_inKeys()`.
+         * 
+         * The keys are a parameter, so every chunk runs the same cached statement.
+         * 
+         * @param column The column to match.
+         * @return The SQL condition.
+         */
+        static std::string _inCondition(const std::string &column)
+        {
+            return (column + " IN (SELECT value FROM json_each(?))");
+        }
+
+        /**
+         * @brief Formats a chunk of keys as the JSON array bound to `_inCondition()`.
+         * 
+         * @param keys The keys to match against.
+         * @param offset The index of the first key of the chunk.
+         * @return The JSON array of the keys.
+         */
+        static std::string _inKeys(const std::vector<int64_t> &keys, std::size_t offset)
+        {
+            std::string array = "[";
+            std::size_t end = std::min(keys.size(), offset + _relationChunkSize);
+            for (std::size_t i = offset; i < end; i++)
+                array += (i == offset ? "" : ",") + std::to_string(keys[i]);
+            array += "]";
+            return (array);
+        }
+
+        /**
+         * @brief Rejects a condition ordering or limiting the records of a sharded database.
+         * 
+         * Each shard would order and limit its own records, and their concatenation would be neither.
+         * 
+         * @param condition The SQL condition filtering the records.
+         * @throw ModelError If the database is sharded and the condition holds `ORDER BY` or `LIMIT`.
+         */
+        void _checkShardedCondition(const std::string &condition)
+        {
+            if (&_db->shard(0) == _db.get())
+                return;
+
+            // Keywords are only searched outside of string literals and quoted identifiers
+            std::string words;
+            char quote = 0;
+            for (char c : condition)
+            {
+                if (quote)
+                {
+                    if (c == quote)
+                        quote = 0;
+                    words += ' ';
+                }
+                else if (c == '\'' || c == '"' || c == '`' || c == '[')
+                {
+                    quote = (c == '[' ? ']' : c);
+                    words += ' ';
+                }
+                else
+                    words += (std::isalnum(static_cast<unsigned char>(c)) || c == '_' ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : ' ');
+            }
+            std::istringstream in(words);
+            std::string word;
+            std::string previous;
+            while (in >> word)
+            {
+                if (word == "LIMIT" || (previous == "ORDER" && word == "BY"))
+                    throw ModelError("ORDER BY and LIMIT are not merged across shards :" + condition);
+                previous = word;
+            }
+        }
+
+        /**
+         * @brief Returns the database holding the row of this model, see `IDatabase::shard()`.
+         * 
+         * @throw ModelError If the shard key is not a field of the model, or has an unsupported type.
+         */
+        IDatabase &_shardDb()
+        {
+            if (_shardKey.empty())
+                return (_db->shard(static_cast<uint64_t>(_id)));
+
+            auto field = fields.find(_shardKey);
+            if (field == fields.end())
+                throw ModelError("Error parsing key :" + _shardKey);
+            uint64_t key = 0;
+            visitField(field->second, [&](auto &value)
+                       {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (is_optional<T>::value)
+                {
+                    if (value)
+                        key = _shardHash(*value);
+                }
+                else
+                    key = _shardHash(value); });
+            return (_db->shard(key));
+        }
+
+        /**
+         * @brief Hashes the value of a shard key.
+         * 
+         * Integers are their own hash, so that an integer key routes like an `_id` of the same value.
+         * 
+         * @throw ModelError If the value is a `BlobStream`.
+         */
+        template <typename V>
+        static uint64_t _shardHash(const V &value)
+        {
+            if constexpr (std::is_integral<V>::value)
+                return (static_cast<uint64_t>(value));
+            else if constexpr (std::is_same<V, std::vector<std::byte>>::value)
+                return (std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char *>(value.data()), value.size())));
+            else if constexpr (std::is_same<V, BlobStream>::value)
+                throw ModelError("Unsupported type for shard key");
+            else
+                return (std::hash<V>()(value));
+        }
+
+        /**
+         * @brief Returns the column name of the field stored at an address.
+         * 
+         * @param address The address of a member of this model.
+         * @return The column name of the field.
+         * @throw ModelError If the member is not a field of the model.
+         */
+        std::string _columnOf(const void *address) const
+        {
+            for (const auto &[columnName, field] : fields)
+            {
+                bool found = false;
+                visitField(field, [&](auto &value)
+                           { found = (static_cast<const void *>(&value) == address); });
+                if (found)
+                    return (columnName);
+            }
+            throw ModelError("Member is not a field of :" + getTableName());
+        }
+
+        /**
+         * @brief Appends the columns of a result row to their buffers, see `fetchColumns()`.
+         * 
+         * @param buffers The buffers of the fetched columns.
+         * @param row The result row.
+         * @param positions The index in the row of the column of each buffer.
+         */
+        template <typename Buffers, std::size_t... I>
+        static void _appendColumns(Buffers &buffers, IRow &row, const std::array<int, sizeof...(I)> &positions, std::index_sequence<I...>)
+        {
+            (std::get<I>(buffers).append(row, positions[I]), ...);
+        }
+
+        /**
+         * @brief Ensures the table of a model exists, whether it declares a `SCHEMA` or not.
+         * 
+         * @param model The model, as its most derived type.
+         * @throw DatabaseError If the table creation fails.
+         */
+        template <typename T>
+        static void _createTableOf(T &model)
+        {
+            if constexpr (has_schema<T>::value)
+                model.template _createStaticTable<T, true>();
+            else
+                model._createTableIfNotExists();
+        }
+
+        /**
+         * @brief Inserts the records of a stream through a model, see `importStream()`.
+         * 
+         * @param model The model receiving each record, whose table exists.
+         * @return The number of imported records.
+         */
+        template <typename T>
+        int64_t _importRecords(T &model, std::istream &in, DataFormat format, const ImportOptions &options)
+        {
+            /**
+             * @brief A field bound by the inserts.
+             */
+            struct Column
+            {
+                FieldInfo *field;       ///< The field of the model.
+                const FieldInfo *reset; ///< The same field of a model left to its default values.
+            };
+
+            T defaults(_db);
+            std::string table = model.getTableName();
+            std::unordered_map<std::string, FieldInfo> withId;
+            std::unordered_map<std::string, FieldInfo> withoutId;
+            std::unordered_map<std::string, std::size_t> slots;
+            std::vector<Column> columns;
+            for (auto &[columnName, field] : model.fields)
+                if (field.typeId != typeid(BlobStream))
+                {
+                    withId.insert({columnName, field});
+                    if (columnName != "_id")
+                        withoutId.insert({columnName, field});
+                    slots.insert({columnName, columns.size()});
+                    columns.push_back({&field, &defaults.fields.at(columnName)});
+                }
+
+            // The parameters follow the iteration order of the maps the statements are built from
+            std::string upsert = _db->qbuilder->insertQuery(table, withId);
+            std::string insert = _db->qbuilder->insertQuery(table, withoutId);
+            std::vector<FieldInfo> upsertParams;
+            std::vector<FieldInfo> insertParams;
+            for (const auto &[columnName, field] : withId)
+                upsertParams.push_back(field);
+            for (const auto &[columnName, field] : withoutId)
+                insertParams.push_back(field);
 
-            if (fields.at(key).typeId == typeid(int))
+            bool sharded = (&_db->shard(0) != _db.get());
+            RecordReader reader(in, format);
+            std::vector<std::string> names;
+            std::vector<std::size_t> positions;
+            std::vector<uint8_t> assigned(columns.size());
+            std::unique_ptr<Transaction> transaction;
+            int64_t count = 0;
+            while (reader.next())
             {
-                int &value = std::any_cast<std::reference_wrapper<int>>(fields.at(key).value).get();
-                _parseStr<int>(input, value);
+                bool hasId = false;
+                std::fill(assigned.begin(), assigned.end(), 0);
+                for (std::size_t i = 0; i < reader.size(); i++)
+                {
+                    // NDJSON records usually list their keys in the same order
+                    if (i == names.size() || names[i] != reader.name(i))
+                    {
+                        auto slot = slots.find(std::string(reader.name(i)));
+                        if (slot == slots.end())
+                            throw ModelError("Unknown column :" + std::string(reader.name(i)));
+                        names.resize(std::max(names.size(), i + 1));
+                        positions.resize(names.size());
+                        names[i] = reader.name(i);
+                        positions[i] = slot->second;
+                    }
+                    std::size_t c = positions[i];
+                    assigned[c] = 1;
+                    if (names[i] == "_id")
+                        hasId = !reader.isNull(i);
+                    if (!_assignField(columns[c].field, columns[c].reset, reader, i))
+                        throw ModelError("Invalid value for column :" + names[i] + " in record " + std::to_string(reader.record()));
+                }
+                for (std::size_t c = 0; c < columns.size(); c++)
+                    if (!assigned[c])
+                        _assignField(columns[c].field, columns[c].reset, reader, std::string::npos);
+
+                // Each shard numbers its own rows, so _id values would collide across shards
+                if (!hasId && sharded)
+                    throw ModelError("Imported records need an _id on sharded table :" + table + ", record " +
+                                     std::to_string(reader.record()) + " has none");
+                if (!transaction)
+                    transaction = std::make_unique<Transaction>(_db);
+                IDatabase &db = (hasId ? model._shardDb() : *_db);
+                if (hasId)
+                    db.exec(upsert, upsertParams, nullptr);
+                else
+                    db.exec(insert, insertParams, nullptr);
+                if (++count % static_cast<int64_t>(std::max<std::size_t>(options.batchSize, 1)) == 0)
+                {
+                    transaction->commit();
+                    transaction.reset();
+                }
             }
-            else if (fields.at(key).typeId == typeid(double))
+            if (transaction)
+                transaction->commit();
+            return (count);
+        }
+
+        /**
+         * @brief Sets a field of a model from a value of a record, see `importStream()`.
+         * 
+         * @param field The field to set.
+         * @param reset The same field of a model left to its default values.
+         * @param reader The reader of the record.
+         * @param i The index of the value in the record, or `std::string::npos` to reset the field.
+         * @return False if the value is invalid for the type of the field.
+         */
+        static bool _assignField(FieldInfo *field, const FieldInfo *reset, const RecordReader &reader, std::size_t i)
+        {
+            bool valid = true;
+            visitField(*field, [&](auto &value)
+                       {
+                using V = std::decay_t<decltype(value)>;
+                if constexpr (!std::is_same<V, BlobStream>::value)
+                {
+                    if (i == std::string::npos || (reader.isNull(i) && !is_optional<V>::value))
+                        value = std::any_cast<std::reference_wrapper<V>>(reset->value).get();
+                    else if constexpr (is_optional<V>::value)
+                    {
+                        if (reader.isNull(i))
+                            value.reset();
+                        else
+                            valid = RecordReader::parse(reader.value(i), value.emplace());
+                    }
+                    else
+                        valid = RecordReader::parse(reader.value(i), value);
+                } });
+            return (valid);
+        }
+
+        /**
+         * @brief Drops the non-unique indexes of a table, see `importStream()`.
+         * 
+         * @param table The name of the table.
+         * @return The statements recreating the dropped indexes.
+         * @throw DatabaseError If a query fails.
+         */
+        std::vector<std::string> _dropIndexes(const std::string &table)
+        {
+            std::vector<std::string> names;
+            std::vector<std::string> statements;
+            std::string tableName = table;
+            // Sharded databases return the indexes of every shard
+            RowCallBackWrapper cb([&](IRow &row) -> int
+                                  {
+                        std::string name(row.getText(0));
+                        if (std::find(names.begin(), names.end(), name) == names.end())
+                        {
+                            names.push_back(name);
+                            statements.emplace_back(row.getText(1));
+                        }
+                        return 0; });
+            _db->exec("SELECT m.name, m.sql FROM sqlite_master m JOIN pragma_index_list(?) l ON l.name = m.name "
+                      "WHERE m.type = 'index' AND m.sql IS NOT NULL AND l.\"unique\" = 0;",
+                      {FieldInfo(std::ref(tableName), typeid(std::string))}, &cb);
+            for (const auto &name : names)
+                _db->exec("DROP INDEX IF EXISTS \"" + name + "\";", nullptr);
+            return (statements);
+        }
+
+        /**
+         * @brief Recreates the indexes dropped by `_dropIndexes()`, each one even if another fails.
+         * 
+         * @param statements The statements recreating the indexes.
+         * @return A description of the indexes that could not be recreated, empty if none.
+         */
+        std::string _recreateIndexes(const std::vector<std::string> &statements)
+        {
+            std::string failures;
+            for (const auto &statement : statements)
             {
-                double &value = std::any_cast<std::reference_wrapper<double>>(fields.at(key).value).get();
-                _parseStr<double>(input, value);
+                Result<void> result = _db->tryExec(statement, nullptr);
+                if (!result)
+                    failures += (failures.empty() ? "unable to recreate the deferred indexes: " : "; ") +
+                                statement + ": " + result.error().message();
             }
-            else if (fields.at(key).typeId == typeid(std::string))
+            return (failures);
+        }
+
+        /**
+         * @brief Reads an integer field by its column name.
+         * 
+         * @param key The column name of the field.
+         * @return The value of the field.
+         * @throw ModelError If the field does not exist or is not an integer.
+         */
+        int64_t _integerField(const std::string &key) const
+        {
+            auto field = fields.find(key);
+            if (field == fields.end())
+                throw ModelError("Error parsing key :" + key);
+
+            std::optional<int64_t> result;
+            visitField(field->second, [&](auto &value)
+                       {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (std::is_integral<T>::value)
+                    result = static_cast<int64_t>(value);
+                else if constexpr (is_optional<T>::value)
+                {
+                    if constexpr (std::is_integral<typename T::value_type>::value)
+                    {
+                        if (value)
+                            result = static_cast<int64_t>(*value);
+                    }
+                } });
+            if (!result)
+                throw ModelError("Field is not an integer :" + key);
+            return (*result);
+        }
+
+        /**
+         * @brief Reads a column of a result row into a value, without going through text.
+         * 
+         * @param row The result row.
+         * @param col The index of the column.
+         * @param value The value to set.
+         */
+        template <typename T>
+        static void _readColumn(IRow &row, int col, T &value)
+        {
+            if constexpr (is_optional<T>::value)
             {
-                std::string &value = std::any_cast<std::reference_wrapper<std::string>>(fields.at(key).value).get();
-                _parseStr<std::string>(input, value);
+                if (row.isNull(col))
+                    value.reset();
+                else
+                    _readColumn(row, col, value.emplace());
             }
-            else if (fields.at(key).typeId == typeid(bool))
+            else if constexpr (std::is_same<T, std::string>::value)
+                value.assign(row.getText(col));
+            else if constexpr (std::is_same<T, std::vector<std::byte>>::value)
             {
-                bool &value = std::any_cast<std::reference_wrapper<bool>>(fields.at(key).value).get();
-                _parseStr<bool>(input, value);
+                std::size_t size = 0;
+                const std::byte *blob = row.getBlob(col, size);
+                value.assign(blob, blob + size);
             }
+            else if constexpr (std::is_same<T, BlobStream>::value)
+                value._size = static_cast<std::size_t>(row.getInt64(col)); // selected as length(column)
+            else if constexpr (std::is_floating_point<T>::value)
+                value = static_cast<T>(row.getDouble(col));
             else
+                value = static_cast<T>(row.getInt64(col));
+        }
+
+        /**
+         * @brief Sets a field from a column of a result row.
+         * 
+         * NULL values leave non-optional fields untouched and reset optional ones.
+         * 
+         * @param key The column name of the field.
+         * @param row The result row.
+         * @param col The index of the column.
+         * @throw ModelError If the field does not exist or its type is not supported.
+         */
+        void updateField(const std::string &key, IRow &row, int col)
+        {
+            auto field = fields.find(key);
+            if (field == fields.end())
+                throw ModelError("Error parsing key :" + key);
+
+            bool supported = visitField(field->second, [&](auto &value)
+                                        {
+                if (is_optional<std::decay_t<decltype(value)>>::value || !row.isNull(col))
+                    _readColumn(row, col, value); });
+            if (!supported)
                 throw ModelError("Unsupported type for value formatting");
+            if (field->second.typeId == typeid(BlobStream))
+                _attachBlobStream(key, field->second);
+        }
+
+        /**
+         * @brief Registers the columns of a compile-time schema as fields, see `SCHEMA`.
+         * 
+         * @param model This model, as its most derived type.
+         * @return True, to initialize the member calling it.
+         */
+        template <typename T>
+        bool _registerSchema(T &model)
+        {
+            StaticQueryBuilder<T>::forEach([&](auto I)
+                                           {
+                const auto &column = std::get<decltype(I)::value>(T::_schema.columns);
+                auto &value = model.*column.member;
+                fields.insert({std::string(column.name), FieldInfo(std::ref(value), std::type_index(typeid(value)))}); });
+            return (true);
+        }
+
+        /**
+         * @brief Binds a value to a statement parameter with the matching typed call.
+         * 
+         * @param params The parameters of the statement.
+         * @param index The 1-based index of the parameter.
+         * @param value The value to bind, which must outlive the execution.
+         */
+        template <typename V>
+        static void _bindValue(IParams &params, int index, const V &value)
+        {
+            if constexpr (is_optional<V>::value)
+            {
+                if (value)
+                    _bindValue(params, index, *value);
+                else
+                    params.bindNull(index);
+            }
+            else if constexpr (std::is_same<V, BlobStream>::value)
+            {
+                if (value.reserved())
+                    params.bindZeroBlob(index, *value.reserved());
+                else
+                    params.bindNull(index);
+            }
+            else if constexpr (std::is_same<V, std::string>::value)
+                params.bindText(index, value);
+            else if constexpr (std::is_same<V, std::vector<std::byte>>::value)
+                params.bindBlob(index, value.data(), value.size());
+            else if constexpr (std::is_floating_point<V>::value)
+                params.bindDouble(index, value);
+            else
+                params.bindInt64(index, static_cast<int64_t>(value));
+        }
+
+        /**
+         * @brief Sets the columns of a compile-time schema from a row selected by `StaticQueryBuilder`.
+         * 
+         * Columns are read by position, NULL values leaving non-optional members untouched.
+         * 
+         * @param model The model to fill.
+         * @param row The result row.
+         */
+        template <typename T>
+        static void _decodeStatic(T &model, IRow &row)
+        {
+            StaticQueryBuilder<T>::forEach([&](auto I)
+                                           {
+                const auto &column = std::get<decltype(I)::value>(T::_schema.columns);
+                auto &value = model.*column.member;
+                using V = std::decay_t<decltype(value)>;
+                if (is_optional<V>::value || !row.isNull(I))
+                    _readColumn(row, I, value);
+                if constexpr (std::is_same<V, BlobStream>::value)
+                    model._attachBlobStream(std::string(column.name), model.fields.at(std::string(column.name))); });
+        }
+
+        /**
+         * @brief Saves a model declared with `SCHEMA`, see `save()`.
+         * 
+         * Runs the statements generated by `StaticQueryBuilder`, binding each column by position.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned.
+         */
+        template <typename T, bool Throw = true>
+        Result<void> _saveStatic()
+        {
+            using Q = StaticQueryBuilder<T>;
+            QueryContextScope scope(typeid(*this));
+            Result<void> result = _createStaticTable<T, Throw>();
+            if (!result)
+                return (result);
+
+            T &model = static_cast<T &>(*this);
+            std::vector<BlobStream *> streams;
+            Q::forEach([&](auto I)
+                       {
+                const auto &column = std::get<decltype(I)::value>(T::_schema.columns);
+                if constexpr (Q::template isStream<decltype(I)::value>())
+                    streams.push_back(&_attachBlobStream(std::string(column.name), fields.at(std::string(column.name)))); });
+
+            BindCallBackWrapper binder([&](IParams &params)
+                                       { Q::forEach([&](auto I)
+                                                    { _bindValue(params, static_cast<int>(I + 1), model.*std::get<decltype(I)::value>(T::_schema.columns).member); }); });
+            result = _execute<Throw>(_shardDb(), Q::template query<Q::insertSQL>(), binder, nullptr);
+            if (result)
+                _settleBlobStreams(streams);
+            return (result);
+        }
+
+        /**
+         * @brief Removes a model declared with `SCHEMA`, see `remove()`.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned.
+         */
+        template <typename T, bool Throw = true>
+        Result<void> _removeStatic()
+        {
+            using Q = StaticQueryBuilder<T>;
+            QueryContextScope scope(typeid(*this));
+            Result<void> result = _createStaticTable<T, Throw>();
+            if (!result)
+                return (result);
+
+            BindCallBackWrapper binder([&](IParams &params)
+                                       { params.bindInt64(1, _id); });
+            return (_execute<Throw>(_shardDb(), Q::template query<Q::removeSQL>(), binder, nullptr));
+        }
+
+        /**
+         * @brief Ensures the table of a model declared with `SCHEMA` exists, see `_createTableIfNotExists()`.
+         * 
+         * @tparam Throw Whether database failures are thrown, or returned.
+         */
+        template <typename T, bool Throw>
+        Result<void> _createStaticTable()
+        {
+            using Q = StaticQueryBuilder<T>;
+            if (!_tableCreated)
+            {
+                Result<void> result = _execute<Throw>(*_db, Q::template query<Q::createSQL>(), nullptr);
+                if (result)
+                    result = _addMissingColumns<Throw>();
+                if (result)
+                    result = _createFullTextIndex<Throw>();
+                if (!result)
+                    return (result);
+                _tableCreated = true;
+            }
+            return (Result<void>());
+        }
+
+        /**
+         * @brief Binds a `BlobStream` field to the BLOB stored in this model's row.
+         * 
+         * The row is resolved when the stream is accessed, from the model's current `_id`.
+         * 
+         * @param key The column name of the field.
+         * @param field The `BlobStream` field.
+         * @return The bound stream.
+         */
+        BlobStream &_attachBlobStream(const std::string &key, const FieldInfo &field)
+        {
+            BlobStream &stream = std::any_cast<std::reference_wrapper<BlobStream>>(field.value).get();
+            if (!stream._open)
+                stream._open = [this, key](bool writable)
+                {
+                    // Tables created before _id aliased the rowid may have diverging rowids
+                    int64_t rowid = _id;
+                    RowCallBackWrapper cb([&](IRow &row) -> int
+                                          {
+                        rowid = row.getInt64(0);
+                        return 0; });
+                    IDatabase &db = _shardDb();
+                    db.exec("SELECT rowid FROM " + getTableName() + " WHERE _id = ?;", {FieldInfo(std::ref(_id), typeid(int))}, &cb);
+                    return db.openBlob(getTableName(), key, rowid, writable);
+                };
+            return (stream);
         }
     };
 
@@ -0,0 +1,186 @@
+/**
+ * @file BlobStream.hpp
+ * @brief Defines a model field type giving chunked access to large BLOBs.
+ */
+
+#include <memory>
+#include <optional>
+#include <functional>
+#include <istream>
+#include <vector>
+#include <algorithm>
+#include "../Database/IBlob.hpp"
+#include "../Exceptions/Model.hpp"
+
+#pragma once
+
+namespace sqlmate
+{
+    class AModel;
+
+    /**
+     * @class BlobStream
+     * @brief Model field type for large binary payloads, read and written in chunks.
+     *
+     * Unlike a `std::vector<std::byte>` field, the content of a `BlobStream` is never loaded with
+     * the model: only its size is. The bytes are accessed through incremental BLOB I/O on the row
+     * the model was saved to or loaded from, keeping memory usage independent of the payload size.
+     *
+     * A BLOB cannot grow in place: call `reserve()` before `save()` to allocate a zero-filled BLOB
+     * of the final size, then fill it with `write()` or `writeFrom()`.
+     */
+    class BlobStream
+    {
+    public:
+        /**
+         * @typedef opener
+         * @brief Opens a handle on the BLOB backing the stream, read-only or writable.
+         */
+        typedef std::function<std::shared_ptr<IBlob>(bool writable)> opener;
+
+        /**
+         * @brief Requests a zero-filled BLOB of the given size to be written on the next save.
+         *
+         * @param size The size of the BLOB in bytes.
+         */
+        void reserve(std::size_t size)
+        {
+            _reserved = size;
+        }
+
+        /**
+         * @brief Returns the size requested by `reserve()` and not saved yet, if any.
+         */
+        const std::optional<std::size_t> &reserved() const
+        {
+            return (_reserved);
+        }
+
+        /**
+         * @brief Returns the size of the stored BLOB in bytes.
+         */
+        std::size_t size() const
+        {
+            return (_size);
+        }
+
+        /**
+         * @brief Reads bytes from the stored BLOB.
+         *
+         * @param offset The offset of the first byte to read.
+         * @param buffer The buffer receiving the bytes.
+         * @param length The maximum number of bytes to read.
+         * @return The number of bytes read, smaller than `length` at the end of the BLOB.
+         * @throw ModelError If the stream is not bound to a stored row.
+         * @throw DatabaseError If the read fails.
+         */
+        std::size_t read(std::size_t offset, void *buffer, std::size_t length) const
+        {
+            if (offset >= _size || length == 0)
+                return (0);
+            length = std::min(length, _size - offset);
+            _openBlob(false)->read(offset, buffer, length);
+            return (length);
+        }
+
+        /**
+         * @brief Writes bytes into the stored BLOB.
+         *
+         * @param offset The offset of the first byte to write.
+         * @param data The bytes to write.
+         * @param length The number of bytes to write.
+         * @throw ModelError If the stream is not bound to a stored row or the range exceeds its size.
+         * @throw DatabaseError If the write fails.
+         */
+        void write(std::size_t offset, const void *data, std::size_t length)
+        {
+            if (offset + length > _size)
+                throw ModelError("BlobStream write out of range, reserve() a larger size and save first");
+            if (length)
+                _openBlob(true)->write(offset, data, length);
+        }
+
+        /**
+         * @brief Reads the whole BLOB in chunks, handing each one to a sink.
+         *
+         * A single handle and a single buffer of `chunkSize` bytes are used for the whole read,
+         * so the content can be streamed to a file or a socket with constant memory.
+         *
+         * @param sink A callable taking `(const std::byte *data, std::size_t length)`.
+         * @param chunkSize The size of the chunks in bytes.
+         * @return The number of bytes read.
+         * @throw ModelError If the stream is not bound to a stored row.
+         * @throw DatabaseError If a read fails.
+         */
+        template <typename F>
+        std::size_t readChunks(F &&sink, std::size_t chunkSize = _defaultChunkSize) const
+        {
+            if (_size == 0)
+                return (0);
+            std::shared_ptr<IBlob> blob = _openBlob(false);
+            std::vector<std::byte> buffer(std::min(chunkSize, _size));
+            std::size_t offset = 0;
+            while (offset < _size)
+            {
+                std::size_t length = std::min(buffer.size(), _size - offset);
+                blob->read(offset, buffer.data(), length);
+                sink(static_cast<const std::byte *>(buffer.data()), length);
+                offset += length;
+            }
+            return (offset);
+        }
+
+        /**
+         * @brief Fills the stored BLOB from an input stream, in chunks.
+         *
+         * Reading stops at the end of the input or of the BLOB, whichever comes first.
+         *
+         * @param in The input stream to read from.
+         * @param offset The offset of the first byte to write.
+         * @param chunkSize The size of the chunks in bytes.
+         * @return The number of bytes written.
+         * @throw ModelError If the stream is not bound to a stored row.
+         * @throw DatabaseError If a write fails.
+         */
+        std::size_t writeFrom(std::istream &in, std::size_t offset = 0, std::size_t chunkSize = _defaultChunkSize)
+        {
+            if (offset >= _size)
+                return (0);
+            std::shared_ptr<IBlob> blob = _openBlob(true);
+            std::vector<char> buffer(std::min(chunkSize, _size - offset));
+            std::size_t written = 0;
+            while (offset < _size && in)
+            {
+                in.read(buffer.data(), std::min(buffer.size(), _size - offset));
+                std::size_t length = static_cast<std::size_t>(in.gcount());
+                if (length == 0)
+                    break;
+                blob->write(offset, buffer.data(), length);
+                offset += length;
+                written += length;
+            }
+            return (written);
+        }
+
+    private:
+        friend class AModel;
+
+        static constexpr std::size_t _defaultChunkSize = 64 * 1024; ///< Default chunk size of streaming reads and writes.
+
+        opener _open;                       ///< Opens the BLOB of the row the stream is bound to.
+        std::size_t _size = 0;              ///< Size of the stored BLOB in bytes.
+        std::optional<std::size_t> _reserved; ///< Size of the zero-filled BLOB to write on the next save.
+
+        /**
+         * @brief Opens a handle on the stored BLOB.
+         *
+         * @throw ModelError If the stream is not bound to a stored row.
+         */
+        std::shared_ptr<IBlob> _openBlob(bool writable) const
+        {
+            if (!_open)
+                throw ModelError("BlobStream is not bound to a stored row");
+            return (_open(writable));
+        }
+    };
+} // namespace sqlmate
@@ -0,0 +1,811 @@
+/**
+ * @file BulkIO.hpp
+ * @brief CSV and NDJSON record streams read by `AModel::importStream()` and written by `AModel::exportStream()`.
+ */
+
+#include "../Database/IDatabase.hpp"
+#include "../Exceptions/Model.hpp"
+#include "../QueryBuilder/QueryBuilder.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @enum DataFormat
+     * @brief Enum representing the text formats of bulk imports and exports.
+     */
+    enum DataFormat
+    {
+        CSV,   ///< Comma-separated values with a header line naming the columns, see RFC 4180.
+        NDJSON ///< One JSON object per line, mapping column names to values.
+    };
+
+    /**
+     * @struct ImportOptions
+     * @brief Describes how `AModel::importStream()` writes the records.
+     */
+    struct ImportOptions
+    {
+        std::size_t batchSize = 10000; /**< Records inserted per transaction. */
+        bool deferIndexes = false;     /**< True to drop the non-unique indexes of the table during the import and recreate them once it is done. */
+    };
+
+    /**
+     * @enum ValueKind
+     * @brief Enum representing how the values of a column are written by a `RecordWriter`.
+     */
+    enum ValueKind
+    {
+        VALUE_INTEGER, ///< An integer, written as digits.
+        VALUE_REAL,    ///< A floating-point number, written in its shortest exact form.
+        VALUE_BOOLEAN, ///< A boolean, written as `1`/`0` in CSV and `true`/`false` in NDJSON.
+        VALUE_TEXT,    ///< A text, quoted when needed.
+        VALUE_BLOB     ///< A BLOB, written as hexadecimal text.
+    };
+
+    /**
+     * @brief Returns how the values of a field type are written.
+     */
+    template <typename V>
+    constexpr ValueKind valueKind()
+    {
+        if constexpr (is_optional<V>::value)
+            return (valueKind<typename V::value_type>());
+        else if constexpr (std::is_same<V, bool>::value)
+            return (VALUE_BOOLEAN);
+        else if constexpr (std::is_integral<V>::value)
+            return (VALUE_INTEGER);
+        else if constexpr (std::is_floating_point<V>::value)
+            return (VALUE_REAL);
+        else if constexpr (std::is_same<V, std::string>::value)
+            return (VALUE_TEXT);
+        else
+            return (VALUE_BLOB);
+    }
+
+    /**
+     * @class RecordReader
+     * @brief Reads the records of a CSV or NDJSON stream, one at a time.
+     *
+     * The stream is read in large chunks; the names and values of the current record are views
+     * into the chunk, valid until `next()` is called again. In CSV, an empty unquoted field is NULL
+     * and `""` an empty text. In NDJSON, `true` and `false` read as `1` and `0`, and nested objects
+     * or arrays are rejected.
+     */
+    class RecordReader
+    {
+    public:
+        /**
+         * @brief Constructs a reader of a stream.
+         *
+         * @param in The stream to read.
+         * @param format The format of the stream.
+         */
+        RecordReader(std::istream &in, DataFormat format) : _in(in), _format(format) {}
+
+        /**
+         * @brief Reads the next record, after the header line in CSV.
+         *
+         * @return True if a record was read, false at the end of the stream.
+         * @throw ModelError If the record is malformed.
+         */
+        bool next()
+        {
+            if (_format == CSV && _header.empty())
+            {
+                if (!_read())
+                    return (false);
+                for (std::size_t i = 0; i < _values.size(); i++)
+                    _header.emplace_back(_values[i]);
+                for (const auto &name : _header)
+                    _names.emplace_back(name);
+            }
+            return (_read());
+        }
+
+        /**
+         * @brief Returns the number of fields of the current record.
+         */
+        std::size_t size() const { return (_values.size()); }
+
+        /**
+         * @brief Returns the column name of a field of the current record.
+         */
+        std::string_view name(std::size_t i) const { return (_names[i]); }
+
+        /**
+         * @brief Returns the value of a field of the current record, empty if it is NULL.
+         */
+        std::string_view value(std::size_t i) const { return (_values[i]); }
+
+        /**
+         * @brief Checks whether a field of the current record is NULL.
+         */
+        bool isNull(std::size_t i) const { return (_nulls[i]); }
+
+        /**
+         * @brief Returns the number of the current record, the CSV header being record 1.
+         */
+        std::size_t record() const { return (_record); }
+
+        /**
+         * @brief Parses the text of a field into a value of a model.
+         *
+         * Integers and reals are read in full and must fit the type of the field, booleans as `1`,
+         * `0`, `true` or `false`, and BLOBs as hexadecimal text.
+         *
+         * @return True if the text is a valid value of the type.
+         */
+        template <typename V>
+        static bool parse(std::string_view text, V &value)
+        {
+            const char *end = text.data() + text.size();
+            if constexpr (std::is_same<V, bool>::value)
+            {
+                value = (text == "1" || text == "true");
+                return (value || text == "0" || text == "false");
+            }
+            else if constexpr (std::is_integral<V>::value || std::is_floating_point<V>::value)
+            {
+                // Parsed in the type of the field, so that out of range values fail instead of wrapping
+                auto result = std::from_chars(text.data(), end, value);
+                return (result.ec == std::errc() && result.ptr == end && !text.empty());
+            }
+            else if constexpr (std::is_same<V, std::string>::value)
+            {
+                value.assign(text);
+                return (true);
+            }
+            else if constexpr (std::is_same<V, std::vector<std::byte>>::value)
+            {
+                if (text.size() % 2)
+                    return (false);
+                value.resize(text.size() / 2);
+                for (std::size_t i = 0; i < value.size(); i++)
+                {
+                    int high = _hexDigit(text[2 * i]);
+                    int low = _hexDigit(text[2 * i + 1]);
+                    if (high < 0 || low < 0)
+                        return (false);
+                    value[i] = static_cast<std::byte>(high << 4 | low);
+                }
+                return (true);
+            }
+            else
+                return (false);
+        }
+
+    private:
+        /**
+         * @enum Status
+         * @brief The outcome of parsing a record from the buffered chunk.
+         */
+        enum Status
+        {
+            COMPLETE,   ///< A record was parsed.
+            INCOMPLETE, ///< The chunk ends within the record.
+            END         ///< There are no more records.
+        };
+
+        static constexpr std::size_t _chunkSize = 1 << 20; ///< Bytes read from the stream at once.
+
+        std::istream &_in;                       ///< The stream read.
+        DataFormat _format;                      ///< The format of the stream.
+        std::string _buffer;                     ///< The chunk read from the stream.
+        std::size_t _pos = 0;                    ///< The start of the next record in `_buffer`.
+        bool _eof = false;                       ///< Whether the stream was read to its end.
+        std::size_t _record = 0;                 ///< The number of records read.
+        std::vector<std::string> _header;        ///< The column names of the CSV header.
+        std::vector<std::string_view> _names;    ///< The column names of the fields of the current record.
+        std::vector<std::string_view> _values;   ///< The values of the fields of the current record.
+        std::vector<uint8_t> _nulls;             ///< Whether each field of the current record is NULL.
+        std::deque<std::string> _unescaped;      ///< Storage of the names and values holding escapes.
+        std::size_t _unescapedUsed = 0;          ///< The entries of `_unescaped` used by the current record.
+
+        /**
+         * @brief Reads the next record, refilling the chunk as needed.
+         */
+        bool _read()
+        {
+            for (;;)
+            {
+                Status status = (_format == CSV ? _parseCsv() : _parseJson());
+                if (status == COMPLETE)
+                {
+                    _record++;
+                    return (true);
+                }
+                if (status == END)
+                    return (false);
+                _buffer.erase(0, _pos);
+                _pos = 0;
+                std::size_t size = _buffer.size();
+                _buffer.resize(size + _chunkSize);
+                _in.read(&_buffer[size], _chunkSize);
+                _buffer.resize(size + static_cast<std::size_t>(_in.gcount()));
+                _eof = !_in;
+            }
+        }
+
+        /**
+         * @brief Starts parsing a record.
+         */
+        void _clear()
+        {
+            _values.clear();
+            _nulls.clear();
+            if (_format == NDJSON)
+                _names.clear();
+            _unescapedUsed = 0;
+        }
+
+        /**
+         * @brief Returns an empty string to unescape a name or value into, kept until the next record.
+         */
+        std::string &_unescape()
+        {
+            if (_unescapedUsed == _unescaped.size())
+                _unescaped.emplace_back();
+            std::string &text = _unescaped[_unescapedUsed++];
+            text.clear();
+            return (text);
+        }
+
+        /**
+         * @brief Throws the error of a malformed record.
+         */
+        [[noreturn]] void _malformed(const std::string &reason) const
+        {
+            throw ModelError("Malformed " + std::string(_format == CSV ? "CSV" : "NDJSON") + " record " +
+                             std::to_string(_record + 1) + " :" + reason);
+        }
+
+        /**
+         * @brief Parses a CSV record from the chunk, skipping blank lines.
+         */
+        Status _parseCsv()
+        {
+            std::size_t pos = _pos;
+            std::size_t size = _buffer.size();
+            while (pos < size && (_buffer[pos] == '\n' || _buffer[pos] == '\r'))
+                pos++;
+            if (pos == size)
+            {
+                _pos = pos;
+                return (_eof ? END : INCOMPLETE);
+            }
+
+            _clear();
+            for (;;)
+            {
+                if (pos < size && _buffer[pos] == '"')
+                {
+                    std::string &text = _unescape();
+                    for (pos++;; pos++)
+                    {
+                        if (pos == size)
+                        {
+                            if (_eof)
+                                _malformed("unterminated quoted field");
+                            return (INCOMPLETE);
+                        }
+                        if (_buffer[pos] != '"')
+                            text += _buffer[pos];
+                        else if (pos + 1 == size && !_eof)
+                            return (INCOMPLETE);
+                        else if (pos + 1 < size && _buffer[pos + 1] == '"')
+                            text += _buffer[++pos];
+                        else
+                            break;
+                    }
+                    pos++;
+                    _values.push_back(text);
+                    _nulls.push_back(false);
+                }
+                else
+                {
+                    std::size_t start = pos;
+                    while (pos < size && _buffer[pos] != ',' && _buffer[pos] != '\n' && _buffer[pos] != '\r')
+                        pos++;
+                    if (pos == size && !_eof)
+                        return (INCOMPLETE);
+                    _values.emplace_back(_buffer.data() + start, pos - start);
+                    _nulls.push_back(pos == start);
+                }
+
+                if (pos == size)
+                {
+                    if (!_eof)
+                        return (INCOMPLETE);
+                    break;
+                }
+                if (_buffer[pos] == ',')
+                {
+                    pos++;
+                    continue;
+                }
+                if (_buffer[pos] == '\r')
+                {
+                    if (pos + 1 == size && !_eof)
+                        return (INCOMPLETE);
+                    pos++;
+                }
+                if (pos < size && _buffer[pos] == '\n')
+                    pos++;
+                else if (pos < size)
+                    _malformed("unexpected character after quoted field");
+                break;
+            }
+            if (!_header.empty() && _values.size() != _header.size())
+                _malformed("expected " + std::to_string(_header.size()) + " fields, got " + std::to_string(_values.size()));
+            _pos = pos;
+            return (COMPLETE);
+        }
+
+        /**
+         * @brief Parses an NDJSON record from the chunk, skipping blank lines.
+         */
+        Status _parseJson()
+        {
+            std::size_t pos = _pos;
+            std::size_t size = _buffer.size();
+            std::size_t end = _buffer.find('\n', pos);
+            while (end != std::string::npos && _blank(pos, end))
+            {
+                pos = end + 1;
+                end = _buffer.find('\n', pos);
+            }
+            if (end == std::string::npos)
+            {
+                if (!_eof)
+                {
+                    _pos = pos;
+                    return (INCOMPLETE);
+                }
+                if (_blank(pos, size))
+                {
+                    _pos = size;
+                    return (END);
+                }
+                end = size;
+            }
+
+            _clear();
+            pos = _skipBlanks(pos, end);
+            if (pos == end || _buffer[pos] != '{')
+                _malformed("expected an object");
+            pos = _skipBlanks(pos + 1, end);
+            if (pos < end && _buffer[pos] == '}')
+                pos++;
+            else
+                for (;;)
+                {
+                    bool null = false;
+                    _names.push_back(_jsonString(pos, end));
+                    pos = _skipBlanks(pos, end);
+                    if (pos == end || _buffer[pos] != ':')
+                        _malformed("expected ':'");
+                    pos = _skipBlanks(pos + 1, end);
+                    _values.push_back(_jsonValue(pos, end, null));
+                    _nulls.push_back(null);
+                    pos = _skipBlanks(pos, end);
+                    if (pos < end && _buffer[pos] == ',')
+                    {
+                        pos = _skipBlanks(pos + 1, end);
+                        continue;
+                    }
+                    if (pos == end || _buffer[pos] != '}')
+                        _malformed("expected ',' or '}'");
+                    pos++;
+                    break;
+                }
+            if (!_blank(pos, end))
+                _malformed("unexpected text after the object");
+            _pos = (end < size ? end + 1 : end);
+            return (COMPLETE);
+        }
+
+        /**
+         * @brief Checks whether a range of the chunk only holds blanks.
+         */
+        bool _blank(std::size_t pos, std::size_t end) const
+        {
+            return (_skipBlanks(pos, end) == end);
+        }
+
+        /**
+         * @brief Returns the position of the first character of a range of the chunk that is not a blank.
+         */
+        std::size_t _skipBlanks(std::size_t pos, std::size_t end) const
+        {
+            while (pos < end && (_buffer[pos] == ' ' || _buffer[pos] == '\t' || _buffer[pos] == '\r'))
+                pos++;
+            return (pos);
+        }
+
+        /**
+         * @brief Parses a JSON string, unescaping it if needed.
+         *
+         * @param pos The position of the opening quote, set past the closing quote.
+         */
+        std::string_view _jsonString(std::size_t &pos, std::size_t end)
+        {
+            if (pos == end || _buffer[pos] != '"')
+                _malformed("expected a string");
+            std::size_t start = ++pos;
+            while (pos < end && _buffer[pos] != '"' && _buffer[pos] != '\\')
+                pos++;
+            if (pos < end && _buffer[pos] == '"')
+                return (std::string_view(_buffer.data() + start, pos++ - start));
+
+            std::string &text = _unescape();
+            text.assign(_buffer, start, pos - start);
+            while (pos < end && _buffer[pos] != '"')
+            {
+                if (_buffer[pos] != '\\')
+                {
+                    text += _buffer[pos++];
+                    continue;
+                }
+                if (++pos == end)
+                    break;
+                switch (_buffer[pos++])
+                {
+                case 'n':
+                    text += '\n';
+                    break;
+                case 't':
+                    text += '\t';
+                    break;
+                case 'r':
+                    text += '\r';
+                    break;
+                case 'b':
+                    text += '\b';
+                    break;
+                case 'f':
+                    text += '\f';
+                    break;
+                case 'u':
+                    _appendCodePoint(text, pos, end);
+                    break;
+                default:
+                    text += _buffer[pos - 1];
+                }
+            }
+            if (pos == end)
+                _malformed("unterminated string");
+            pos++;
+            return (text);
+        }
+
+        /**
+         * @brief Appends the UTF-8 encoding of a `\u` escape, joining surrogate pairs.
+         *
+         * @param pos The position of the first hexadecimal digit, set past the escape.
+         */
+        void _appendCodePoint(std::string &text, std::size_t &pos, std::size_t end)
+        {
+            uint32_t code = _hex4(pos, end);
+            if (code >= 0xD800 && code < 0xDC00 && pos + 1 < end && _buffer[pos] == '\\' && _buffer[pos + 1] == 'u')
+            {
+                std::size_t low = pos + 2;
+                uint32_t next = _hex4(low, end);
+                if (next >= 0xDC00 && next < 0xE000)
+                {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (next - 0xDC00);
+                    pos = low;
+                }
+            }
+            if (code < 0x80)
+                text += static_cast<char>(code);
+            else if (code < 0x800)
+            {
+                text += static_cast<char>(0xC0 | code >> 6);
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                text += static_cast<char>(0xE0 | code >> 12);
+                text += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                text += static_cast<char>(0xF0 | code >> 18);
+                text += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+                text += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        /**
+         * @brief Parses the four hexadecimal digits of a `\u` escape.
+         */
+        uint32_t _hex4(std::size_t &pos, std::size_t end)
+        {
+            uint32_t code = 0;
+            for (int i = 0; i < 4; i++, pos++)
+            {
+                int digit = (pos < end ? _hexDigit(_buffer[pos]) : -1);
+                if (digit < 0)
+                    _malformed("invalid \\u escape");
+                code = code << 4 | static_cast<uint32_t>(digit);
+            }
+            return (code);
+        }
+
+        /**
+         * @brief Parses a JSON scalar value as the text of a field.
+         *
+         * @param pos The position of the value, set past it.
+         * @param null Set to true if the value is `null`.
+         */
+        std::string_view _jsonValue(std::size_t &pos, std::size_t end, bool &null)
+        {
+            if (pos < end && _buffer[pos] == '"')
+                return (_jsonString(pos, end));
+
+            std::size_t start = pos;
+            while (pos < end && _buffer[pos] != ',' && _buffer[pos] != '}' && _buffer[pos] != ' ' &&
+                   _buffer[pos] != '\t' && _buffer[pos] != '\r')
+                pos++;
+            std::string_view token(_buffer.data() + start, pos - start);
+            if (token == "null")
+            {
+                null = true;
+                return (std::string_view());
+            }
+            if (token == "true")
+                return ("1");
+            if (token == "false")
+                return ("0");
+            if (token.empty() || token.find_first_not_of("0123456789+-.eE") != std::string_view::npos)
+                _malformed("unsupported value");
+            return (token);
+        }
+
+        /**
+         * @brief Returns the value of a hexadecimal digit, or -1.
+         */
+        static int _hexDigit(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return (c - '0');
+            if (c >= 'a' && c <= 'f')
+                return (c - 'a' + 10);
+            if (c >= 'A' && c <= 'F')
+                return (c - 'A' + 10);
+            return (-1);
+        }
+    };
+
+    /**
+     * @class RecordWriter
+     * @brief Writes records to a CSV or NDJSON stream, straight from result rows.
+     *
+     * Output is buffered in large chunks. NULL values are written as empty fields in CSV and as
+     * `null` in NDJSON; empty texts are quoted in CSV to tell them apart.
+     */
+    class RecordWriter
+    {
+    public:
+        /**
+         * @brief Constructs a writer, writing the CSV header line.
+         *
+         * @param out The stream to write.
+         * @param format The format of the stream.
+         * @param names The column names of the fields of each record.
+         */
+        RecordWriter(std::ostream &out, DataFormat format, const std::vector<std::string> &names)
+            : _out(out), _format(format)
+        {
+            for (const auto &name : names)
+            {
+                _keys.emplace_back();
+                if (_format == NDJSON)
+                {
+                    _appendJsonString(_keys.back(), name);
+                    _keys.back() += ':';
+                }
+            }
+            if (_format == CSV)
+            {
+                for (std::size_t i = 0; i < names.size(); i++)
+                {
+                    if (i)
+                        _line += ',';
+                    _appendCsvText(_line, names[i]);
+                }
+                _line += '\n';
+            }
+        }
+
+        /**
+         * @brief Flushes the buffered records.
+         */
+        ~RecordWriter()
+        {
+            flush();
+        }
+
+        RecordWriter(const RecordWriter &) = delete;
+        RecordWriter &operator=(const RecordWriter &) = delete;
+
+        /**
+         * @brief Writes a record from the columns of a result row.
+         *
+         * @param row The result row.
+         * @param positions The index in the row of the column of each field.
+         * @param kinds How each field is written.
+         */
+        void write(IRow &row, const std::vector<int> &positions, const std::vector<ValueKind> &kinds)
+        {
+            if (_format == NDJSON)
+                _line += '{';
+            for (std::size_t i = 0; i < positions.size(); i++)
+            {
+                if (i)
+                    _line += ',';
+                if (_format == NDJSON)
+                    _line += _keys[i];
+                _appendValue(row, positions[i], kinds[i]);
+            }
+            _line += (_format == NDJSON ? "}\n" : "\n");
+            if (_line.size() >= _chunkSize)
+                flush();
+        }
+
+        /**
+         * @brief Writes the buffered records to the stream.
+         */
+        void flush()
+        {
+            _out.write(_line.data(), static_cast<std::streamsize>(_line.size()));
+            _line.clear();
+        }
+
+    private:
+        static constexpr std::size_t _chunkSize = 1 << 16; ///< Bytes buffered before writing to the stream.
+
+        std::ostream &_out;             ///< The stream written.
+        DataFormat _format;             ///< The format of the stream.
+        std::vector<std::string> _keys; ///< The quoted key of each field, followed by `:`, in NDJSON.
+        std::string _line;              ///< The buffered records.
+
+        /**
+         * @brief Appends a value of a column of a result row.
+         */
+        void _appendValue(IRow &row, int col, ValueKind kind)
+        {
+            static const char hex[] = "0123456789abcdef";
+
+            if (row.isNull(col))
+            {
+                if (_format == NDJSON)
+                    _line += "null";
+                return;
+            }
+            switch (kind)
+            {
+            case VALUE_BOOLEAN:
+                if (_format == NDJSON)
+                    _line += (row.getInt64(col) ? "true" : "false");
+                else
+                    _line += (row.getInt64(col) ? '1' : '0');
+                break;
+            case VALUE_INTEGER:
+                _appendNumber(row.getInt64(col));
+                break;
+            case VALUE_REAL:
+            {
+                double value = row.getDouble(col);
+                if (std::isfinite(value))
+                    _appendNumber(value);
+                else if (_format == NDJSON)
+                    _line += "null";
+                break;
+            }
+            case VALUE_TEXT:
+                if (_format == NDJSON)
+                    _appendJsonString(_line, row.getText(col));
+                else
+                    _appendCsvText(_line, row.getText(col));
+                break;
+            case VALUE_BLOB:
+            {
+                std::size_t size = 0;
+                const std::byte *blob = row.getBlob(col, size);
+                bool quoted = (_format == NDJSON || size == 0);
+                if (quoted)
+                    _line += '"';
+                for (std::size_t i = 0; i < size; i++)
+                {
+                    _line += hex[std::to_integer<int>(blob[i]) >> 4];
+                    _line += hex[std::to_integer<int>(blob[i]) & 0xf];
+                }
+                if (quoted)
+                    _line += '"';
+                break;
+            }
+            }
+        }
+
+        /**
+         * @brief Appends a number in its shortest exact form.
+         */
+        template <typename N>
+        void _appendNumber(N value)
+        {
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            _line.append(buffer, result.ptr);
+        }
+
+        /**
+         * @brief Appends a CSV field to a string, quoted if it is empty or holds a separator or a quote.
+         */
+        static void _appendCsvText(std::string &out, std::string_view text)
+        {
+            if (!text.empty() && text.find_first_of(",\"\r\n") == std::string_view::npos)
+            {
+                out += text;
+                return;
+            }
+            out += '"';
+            for (char c : text)
+            {
+                if (c == '"')
+                    out += '"';
+                out += c;
+            }
+            out += '"';
+        }
+
+        /**
+         * @brief Appends a JSON string to a string.
+         */
+        static void _appendJsonString(std::string &out, std::string_view text)
+        {
+            static const char hex[] = "0123456789abcdef";
+
+            out += '"';
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += c;
+                }
+                else if (c == '\n')
+                    out += "\\n";
+                else if (c == '\t')
+                    out += "\\t";
+                else if (c == '\r')
+                    out += "\\r";
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    out += "\\u00";
+                    out += hex[(c >> 4) & 0xf];
+                    out += hex[c & 0xf];
+                }
+                else
+                    out += c;
+            }
+            out += '"';
+        }
+    };
+} // namespace sqlmate
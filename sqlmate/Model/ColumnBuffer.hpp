@@ -0,0 +1,125 @@
+/**
+ * @file ColumnBuffer.hpp
+ * @brief Contiguous typed column buffers filled by `AModel::fetchColumns()`.
+ */
+
+#include "../Database/IDatabase.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#pragma once
+
+namespace sqlmate
+{
+    /**
+     * @struct ColumnBuffer
+     * @brief The values of a numeric column, stored contiguously.
+     *
+     * NULL values are stored as `V{}`.
+     *
+     * @tparam V The type of the model member, `int`, `int64_t`, `uint32_t`, `double`, `float` or `bool`.
+     */
+    template <typename V>
+    struct ColumnBuffer
+    {
+        static_assert(std::is_arithmetic<V>::value, "unsupported column type");
+
+        std::vector<V> values; /**< The values, one per row. */
+
+        std::size_t size() const { return values.size(); }
+        V operator[](std::size_t i) const { return values[i]; }
+        void reserve(std::size_t n) { values.reserve(n); }
+
+        /**
+         * @brief Appends the value of a column of a result row.
+         */
+        void append(IRow &row, int col)
+        {
+            if (row.isNull(col))
+                values.push_back(V{});
+            else if constexpr (std::is_floating_point<V>::value)
+                values.push_back(static_cast<V>(row.getDouble(col)));
+            else
+                values.push_back(static_cast<V>(row.getInt64(col)));
+        }
+    };
+
+    /**
+     * @struct ArenaColumnBuffer
+     * @brief The values of a text or BLOB column, stored back to back in a single arena.
+     *
+     * The i-th value spans `arena[offsets[i], offsets[i + 1])`, so `offsets` holds one entry
+     * more than there are rows. NULL values are stored as empty values.
+     */
+    struct ArenaColumnBuffer
+    {
+        std::string arena;                     /**< The bytes of all values, in row order. */
+        std::vector<std::size_t> offsets = {0}; /**< The offset of each value in `arena`, then the size of `arena`. */
+
+        std::size_t size() const { return offsets.size() - 1; }
+        std::string_view operator[](std::size_t i) const
+        {
+            return std::string_view(arena.data() + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        void reserve(std::size_t n) { offsets.reserve(n + 1); }
+    };
+
+    /**
+     * @brief The values of a `std::string` column, see `ArenaColumnBuffer`.
+     */
+    template <>
+    struct ColumnBuffer<std::string> : ArenaColumnBuffer
+    {
+        void append(IRow &row, int col)
+        {
+            if (!row.isNull(col))
+                arena.append(row.getText(col));
+            offsets.push_back(arena.size());
+        }
+    };
+
+    /**
+     * @brief The values of a `std::vector<std::byte>` column, see `ArenaColumnBuffer`.
+     */
+    template <>
+    struct ColumnBuffer<std::vector<std::byte>> : ArenaColumnBuffer
+    {
+        void append(IRow &row, int col)
+        {
+            std::size_t size = 0;
+            const std::byte *blob = row.isNull(col) ? nullptr : row.getBlob(col, size);
+            if (size)
+                arena.append(reinterpret_cast<const char *>(blob), size);
+            offsets.push_back(arena.size());
+        }
+    };
+
+    /**
+     * @brief The values of an optional column, with a validity mask telling NULL values apart.
+     */
+    template <typename V>
+    struct ColumnBuffer<std::optional<V>> : ColumnBuffer<V>
+    {
+        std::vector<uint8_t> valid; /**< 1 for each row holding a value, 0 for each NULL. */
+
+        bool isNull(std::size_t i) const { return !valid[i]; }
+
+        void reserve(std::size_t n)
+        {
+            ColumnBuffer<V>::reserve(n);
+            valid.reserve(n);
+        }
+
+        void append(IRow &row, int col)
+        {
+            ColumnBuffer<V>::append(row, col);
+            valid.push_back(!row.isNull(col));
+        }
+    };
+} // namespace sqlmate
@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include "../Exceptions/Model.hpp"
+#include "../Database/Result.hpp"
 #include <vector>
 
 #pragma once
@@ -51,6 +52,22 @@ namespace sqlmate
          */
         virtual void remove() = 0;
 
+        /**
+         * @brief Saves the current model to the database, returning failures instead of throwing them.
+         * 
+         * Meant for hot paths where failures such as constraint violations are expected.
+         * 
+         * @return A success, or the error of the database.
+         */
+        virtual Result<void> trySave() = 0;
+
+        /**
+         * @brief Removes the current model from the database, returning failures instead of throwing them.
+         * 
+         * @return A success, or the error of the database.
+         */
+        virtual Result<void> tryRemove() = 0;
+
         /**
          * @brief TODO Add createTable and deleteTable methods.
          * 
@@ -0,0 +1,53 @@
+/**
+ * @file Relation.hpp
+ * @brief Describes relationships between models in the sqlmate namespace.
+ */
+
+#include <any>
+#include <string>
+#include <vector>
+#include <functional>
+
+#pragma once
+
+namespace sqlmate
+{
+    class AModel;
+
+    /**
+     * @enum RelationType
+     * @brief Enum representing supported relationship kinds.
+     */
+    enum RelationType
+    {
+        ONE_TO_MANY, ///< The model owns many children referencing it through a foreign key (`HAS_MANY`).
+        MANY_TO_ONE  ///< The model references a single parent through one of its fields (`BELONGS_TO`).
+    };
+
+    /**
+     * @struct RelationInfo
+     * @brief Represents a relationship declared on a model.
+     *
+     * Stores the member receiving the related models and a batch loader able to fetch
+     * the related rows of many models at once.
+     */
+    struct RelationInfo
+    {
+        /**
+         * @brief Constructs a `RelationInfo` instance.
+         *
+         * @param t The kind of relationship.
+         * @param fk The name of the foreign key column.
+         * @param tgt A reference to the member receiving the related models, stored as a `std::any`.
+         * @param loader The batch loader filling the member of every given model.
+         */
+        RelationInfo(RelationType t, std::string fk, std::any tgt,
+                     std::function<void(const std::vector<AModel *> &)> loader)
+            : type(t), foreignKey(fk), target(tgt), load(loader) {}
+
+        RelationType type;                                      /**< The kind of relationship. */
+        std::string foreignKey;                                 /**< The name of the foreign key column. */
+        std::any target;                                        /**< The member receiving the related models. */
+        std::function<void(const std::vector<AModel *> &)> load; /**< Loads the relation for a batch of models in a single query per chunk. */
+    };
+} // namespace sqlmate
@@ -84,4 +84,108 @@ public:                                       \
     {                \
         __VA_ARGS__; \
     }
+
+/**
+ * @brief Macro to declare a column of a compile-time schema, see `SCHEMA`.
+ *
+ * Accepts either the member alone, named after the member, or the member and a column name.
+ */
+#define COLUMN_1(member) sqlmate::column(&_SchemaSelf::member, #member)
+#define COLUMN_2(member, name) sqlmate::column(&_SchemaSelf::member, name)
+#define COLUMN(...) FIELD_HELPER(__VA_ARGS__, COLUMN_2, COLUMN_1, FIELD_ERROR)(__VA_ARGS__)
+
+/**
+ * @brief Macro to describe a model's table at compile time.
+ *
+ * Replaces `TABLE_NAME` and `FIELDS`: the columns are registered as fields on construction,
+ * and the model's statements are generated at compile time by `StaticQueryBuilder`, with
+ * parameters bound and rows decoded per column without going through `FieldInfo`.
+ * Must be placed after the declaration of the members it lists.
+ *
+ * @param modelType The model class.
+ * @param tableName The name of the table.
+ * @param ... The columns, declared with `COLUMN`. `_id` is added first.
+ */
+#define SCHEMA(modelType, tableName, ...)                                                                   \
+public:                                                                                                     \
+    using _SchemaSelf = modelType;                                                                          \
+    static constexpr auto _schema = sqlmate::makeSchema(tableName, sqlmate::column(&modelType::_id, "_id"), \
+                                                        __VA_ARGS__);                                       \
+    std::string getTableName() const override                                                               \
+    {                                                                                                       \
+        return std::string(_schema.table);                                                                  \
+    }                                                                                                       \
+    void save() override                                                                                    \
+    {                                                                                                       \
+        _saveStatic<modelType>();                                                                           \
+    }                                                                                                       \
+    void remove() override                                                                                  \
+    {                                                                                                       \
+        _removeStatic<modelType>();                                                                         \
+    }                                                                                                       \
+    sqlmate::Result<void> trySave() override                                                                \
+    {                                                                                                       \
+        return (_saveStatic<modelType, false>());                                                           \
+    }                                                                                                       \
+    sqlmate::Result<void> tryRemove() override                                                              \
+    {                                                                                                       \
+        return (_removeStatic<modelType, false>());                                                         \
+    }                                                                                                       \
+                                                                                                            \
+private:                                                                                                    \
+    bool _schemaRegistered = this->_registerSchema(*this);                                                  \
+                                                                                                            \
+public:
+
+/**
+ * @brief Macro to declare the full-text indexed columns of a model.
+ * 
+ * The columns must be `std::string` or `std::optional<std::string>` fields. They are indexed
+ * together in one full-text index, queried with `search()`.
+ *
+ * @param ... The names of the columns to index.
+ */
+#define FULLTEXT(...) this->_fullTextColumns = {__VA_ARGS__}
+
+/**
+ * @brief Macro to declare the field routing the rows of a model to a shard, see `ShardedDatabase`.
+ * 
+ * Rows are routed by `_id` when no shard key is declared. The key of a saved model must not change,
+ * its row staying in the shard it was saved to; `findOne()` queries every shard when a key is declared.
+ *
+ * @param column The name of the column of the key.
+ */
+#define SHARD_KEY(column) this->_shardKey = column
+
+/**
+ * @brief Macro to declare a one-to-many relationship.
+ * 
+ * The member must be a `std::vector<std::shared_ptr<Child>>`. It is filled with every `Child`
+ * whose `foreignKey` field holds the `_id` of this model when the relation is eagerly loaded.
+ *
+ * @param member The member receiving the related models.
+ * @param foreignKey The name of the field of the child model referencing this model.
+ */
+#define HAS_MANY(member, foreignKey) this->_hasMany(#member, this->member, foreignKey)
+
+/**
+ * @brief Macro to declare a many-to-one relationship.
+ * 
+ * The member must be a `std::shared_ptr<Parent>`. It is set to the `Parent` whose `_id`
+ * matches the `foreignKey` field of this model when the relation is eagerly loaded.
+ *
+ * @param member The member receiving the related model.
+ * @param foreignKey The name of the field of this model referencing the parent model.
+ */
+#define BELONGS_TO(member, foreignKey) this->_belongsTo(#member, this->member, foreignKey)
+
+/**
+ * @brief Macro to declare multiple relationships at once.
+ *
+ * @param ... The relationships to declare.
+ */
+#define RELATIONS(...) \
+    {                  \
+        __VA_ARGS__;   \
+    }
 }
\ No newline at end of file
@@ -3,6 +3,14 @@
 #include <unordered_map>
 #include <any>
 #include <typeindex>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "../Model/BlobStream.hpp"
 
 #pragma once
 
@@ -28,10 +36,86 @@ namespace sqlmate
          */
         FieldInfo(std::any val, std::type_index tId) : value(val), typeId(tId) {}
 
+        /**
+         * @brief Constructs a `FieldInfo` holding its own copy of a value, such as a query parameter.
+         * 
+         * Fields of models refer to their members; this one refers to a copy kept alive by the
+         * `FieldInfo` and its copies. String literals are stored as `std::string`.
+         * 
+         * @param val The value, of a type supported by `visitField()`.
+         */
+        template <typename V>
+        static FieldInfo of(V val)
+        {
+            using Stored = std::conditional_t<std::is_convertible<V, std::string>::value, std::string, V>;
+            auto owned = std::make_shared<Stored>(std::move(val));
+            FieldInfo field(std::ref(*owned), typeid(Stored));
+            field.owner = owned;
+            return (field);
+        }
+
         std::any value; /**< The value of the field, stored as a generic type.*/
         std::type_index typeId; /**< The type of the field, represented as a `std::type_index`. */
+        std::shared_ptr<void> owner; /**< The copy of the value referred to by `value`, see `of()`. */
     };
 
+    /**
+     * @brief Trait detecting `std::optional` field types, which are mapped to nullable columns.
+     */
+    template <typename T>
+    struct is_optional : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct is_optional<std::optional<T>> : std::true_type
+    {
+    };
+
+    /**
+     * @brief Calls `visitor` with the field's value if the field holds a `T` or a `std::optional<T>`.
+     * 
+     * @return True if the field matched one of the two types, false otherwise.
+     */
+    template <typename T, typename F>
+    bool visitFieldAs(const FieldInfo &field, F &visitor)
+    {
+        if (field.typeId == typeid(T))
+            visitor(std::any_cast<std::reference_wrapper<T>>(field.value).get());
+        else if (field.typeId == typeid(std::optional<T>))
+            visitor(std::any_cast<std::reference_wrapper<std::optional<T>>>(field.value).get());
+        else
+            return (false);
+        return (true);
+    }
+
+    /**
+     * @brief Calls `visitor` with a reference to the field's value, typed as the field's C++ type.
+     * 
+     * Supported types are `int`, `int64_t`, `uint32_t`, `double`, `float`, `bool`, `std::string`,
+     * `std::vector<std::byte>` (BLOB) and `std::optional` of any of them (NULL when empty),
+     * plus `BlobStream` (BLOB accessed incrementally, never optional).
+     * The visitor is usually a generic lambda taking `auto &`.
+     * 
+     * @param field The field to visit.
+     * @param visitor The callable to invoke with the value.
+     * @return True if the field's type is supported, false otherwise.
+     */
+    template <typename F>
+    bool visitField(const FieldInfo &field, F &&visitor)
+    {
+        return (visitFieldAs<int>(field, visitor) ||
+                visitFieldAs<int64_t>(field, visitor) ||
+                visitFieldAs<uint32_t>(field, visitor) ||
+                visitFieldAs<double>(field, visitor) ||
+                visitFieldAs<float>(field, visitor) ||
+                visitFieldAs<bool>(field, visitor) ||
+                visitFieldAs<std::string>(field, visitor) ||
+                visitFieldAs<std::vector<std::byte>>(field, visitor) ||
+                (field.typeId == typeid(BlobStream) &&
+                 (visitor(std::any_cast<std::reference_wrapper<BlobStream>>(field.value).get()), true)));
+    }
+
     /**
      * @class IQueryBuilder
      * @brief Interface for building SQL queries.
@@ -60,11 +144,33 @@ namespace sqlmate
         virtual std::string createTableQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &columns) const = 0; // handle _id to auto incement, Create if not exist
 
         /**
-         * @brief Generates a SQL query for inserting or replacing a row in a table.
+         * @brief Generates a SQL query for adding a column to an existing table.
+         * 
+         * @param tableName The name of the table.
+         * @param columnName The name of the added column.
+         * @param field The field metadata of the column.
+         * @return A SQL string for adding the column.
+         */
+        virtual std::string addColumnQuery(const std::string &tableName, const std::string &columnName, const FieldInfo &field) const = 0;
+
+        /**
+         * @brief Returns the type a column of a field is declared with by `createTableQuery()`.
+         * 
+         * @param field The field metadata of the column.
+         * @return The declared type of the column.
+         */
+        virtual std::string columnType(const FieldInfo &field) const = 0;
+
+        /**
+         * @brief Generates a SQL query for inserting a row in a table, or updating it if its `_id` exists.
+         * 
+         * `BlobStream` columns keep their stored content when bound to NULL.
+         * Values are not inlined: the query holds one positional parameter per entry of `values`,
+         * in the iteration order of the map, to be bound when the query is executed.
          * 
          * @param tableName The name of the table to insert into.
          * @param values A map of column names to their corresponding field values.
-         * @return A SQL string for inserting or replacing a row.
+         * @return A SQL string for inserting or updating a row.
          */
         virtual std::string insertQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &values) const = 0; // insert if not exist
 
@@ -79,6 +185,20 @@ namespace sqlmate
         virtual std::string selectQuery(const std::string &tableName, const std::string &condition = "",
                                         int limit = -1) const = 0;
 
+        /**
+         * @brief Generates a SQL query for selecting the given columns of rows from a table.
+         * 
+         * `BlobStream` columns are selected as their length, so their content is never loaded.
+         * 
+         * @param tableName The name of the table to query.
+         * @param columns A map of column names to their corresponding field metadata.
+         * @param condition An optional condition for filtering rows.
+         * @param limit An optional limit on the number of rows to return. Defaults to no limit.
+         * @return A SQL string for selecting rows.
+         */
+        virtual std::string selectQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &columns,
+                                        const std::string &condition = "", int limit = -1) const = 0;
+
         /**
          * @brief Generates a SQL query for deleting a row from a table.
          * 
@@ -88,6 +208,30 @@ namespace sqlmate
          */
         virtual std::string deleteQuery(const std::string &tableName, int id) const = 0; // delete if exists
 
+        /**
+         * @brief Generates a SQL query for deleting the rows of a table matching a condition.
+         * 
+         * @param tableName The name of the table to delete from.
+         * @param condition The condition selecting the rows, which may hold positional parameters,
+         *        or an empty string for every row.
+         * @return A SQL string for deleting the rows.
+         */
+        virtual std::string deleteWhereQuery(const std::string &tableName, const std::string &condition) const = 0;
+
+        /**
+         * @brief Generates a SQL query for setting columns of the rows of a table matching a condition.
+         * 
+         * The query holds one positional parameter per entry of `values`, in the iteration order of
+         * the map, followed by the parameters of `condition`.
+         * 
+         * @param tableName The name of the table to update.
+         * @param values A map of the updated column names to their new values.
+         * @param condition The condition selecting the rows, or an empty string for every row.
+         * @return A SQL string for updating the rows.
+         */
+        virtual std::string updateWhereQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &values,
+                                             const std::string &condition) const = 0;
+
         /**
          * @brief Generates a SQL query for dropping a table.
          * 
@@ -95,6 +239,30 @@ namespace sqlmate
          * @return A SQL string for dropping the table.
          */
         virtual std::string dropTableQuery(const std::string &tableName) const = 0; // drop if exists
+
+        /**
+         * @brief Generates the SQL statements creating the full-text index of a table.
+         * 
+         * The index is kept in sync with the table by the database itself, and is built from the
+         * existing rows when the table already holds some.
+         * 
+         * @param tableName The name of the indexed table.
+         * @param columns The names of the indexed text columns.
+         * @return A SQL string made of one or more statements.
+         */
+        virtual std::string createFullTextQuery(const std::string &tableName, const std::vector<std::string> &columns) const = 0;
+
+        /**
+         * @brief Generates a SQL query for selecting the rows of a table matching a full-text query, best first.
+         * 
+         * The query holds two positional parameters: the full-text query and the maximum number of rows.
+         * Each row ends with a `_rank` column, lower ranks matching better.
+         * 
+         * @param tableName The name of the indexed table.
+         * @param columns A map of column names to their corresponding field metadata.
+         * @return A SQL string for selecting rows.
+         */
+        virtual std::string searchQuery(const std::string &tableName, const std::unordered_map<std::string, FieldInfo> &columns) const = 0;
     };
 
 } // namespace sqlmate
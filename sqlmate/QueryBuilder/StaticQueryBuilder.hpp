@@ -0,0 +1,342 @@
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <cstddef>
+#include <type_traits>
+#include "./QueryBuilder.hpp"
+
+#pragma once
+
+/**
+ * @file StaticQueryBuilder.hpp
+ * @brief Compile-time model description and SQL generation.
+ */
+namespace sqlmate
+{
+    /**
+     * @struct Column
+     * @brief Describes a column of a model known at compile time.
+     *
+     * @tparam M The pointer to the model member holding the column's value.
+     */
+    template <typename M>
+    struct Column
+    {
+        M member;              /**< The pointer to the model member. */
+        std::string_view name; /**< The name of the column. */
+    };
+
+    /**
+     * @brief Describes a column from a model member and a column name.
+     */
+    template <typename M>
+    constexpr Column<M> column(M member, std::string_view name)
+    {
+        return Column<M>{member, name};
+    }
+
+    /**
+     * @struct Schema
+     * @brief Describes the table of a model known at compile time.
+     *
+     * @tparam Columns The `Column` types of the model, `_id` first.
+     */
+    template <typename... Columns>
+    struct Schema
+    {
+        std::string_view table;         /**< The name of the table. */
+        std::tuple<Columns...> columns; /**< The columns of the table, in declaration order. */
+    };
+
+    /**
+     * @brief Describes a table from its name and columns.
+     */
+    template <typename... Columns>
+    constexpr Schema<Columns...> makeSchema(std::string_view table, Columns... columns)
+    {
+        return Schema<Columns...>{table, std::tuple<Columns...>(columns...)};
+    }
+
+    /**
+     * @brief Trait giving the value type of a pointer to member.
+     */
+    template <typename M>
+    struct member_type;
+
+    template <typename V, typename C>
+    struct member_type<V C::*>
+    {
+        using type = V;
+    };
+
+    /**
+     * @brief Trait detecting models declaring a compile-time schema with `SCHEMA`.
+     */
+    template <typename T, typename = void>
+    struct has_schema : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct has_schema<T, std::void_t<decltype(T::_schema)>> : std::true_type
+    {
+    };
+
+    /**
+     * @brief Counts the characters of a statement being built.
+     */
+    struct SqlLength
+    {
+        std::size_t size = 0;
+
+        constexpr void append(std::string_view text) { size += text.size(); }
+    };
+
+    /**
+     * @brief Holds the characters of a statement built at compile time.
+     *
+     * @tparam N The length of the statement.
+     */
+    template <std::size_t N>
+    struct SqlText
+    {
+        char data[N + 1] = {};
+        std::size_t size = 0;
+
+        constexpr void append(std::string_view text)
+        {
+            for (char c : text)
+                data[size++] = c;
+        }
+
+        constexpr std::string_view view() const { return std::string_view(data, size); }
+    };
+
+    /**
+     * @class StaticQueryBuilder
+     * @brief Generates the SQL statements of a model described by a `Schema` at compile time.
+     *
+     * Statements are built twice by constant evaluation, once to measure them and once to fill a
+     * `SqlText` of that exact length, and are copied into a `std::string` on first use only.
+     * Columns appear in declaration order, so the placeholders and result columns of each statement
+     * match the positions used by the unrolled binding and decoding in `AModel`.
+     *
+     * @tparam T The model type, declaring its schema with `SCHEMA`.
+     */
+    template <typename T>
+    class StaticQueryBuilder
+    {
+    public:
+        static constexpr auto &schema = T::_schema; ///< The description of the model's table.
+        static constexpr std::size_t columnCount = std::tuple_size<std::decay_t<decltype(schema.columns)>>::value; ///< The number of columns, `_id` included.
+
+        /**
+         * @brief Returns the SQL type of a column value type.
+         *
+         * `std::optional` values map to the type of their value, columns being nullable by default.
+         */
+        template <typename V>
+        static constexpr std::string_view sqlType()
+        {
+            using U = typename std::conditional_t<is_optional<V>::value, V, std::optional<V>>::value_type;
+
+            if constexpr (std::is_same<U, bool>::value)
+                return "BOOLEAN";
+            else if constexpr (std::is_integral<U>::value)
+                return "INTEGER";
+            else if constexpr (std::is_floating_point<U>::value)
+                return "REAL";
+            else if constexpr (std::is_same<U, std::string>::value)
+                return "TEXT";
+            else
+                return "BLOB";
+        }
+
+        /**
+         * @brief Checks whether the I-th column holds a `BlobStream`.
+         */
+        template <std::size_t I>
+        static constexpr bool isStream()
+        {
+            using M = decltype(std::get<I>(schema.columns).member);
+            return std::is_same<typename member_type<M>::type, BlobStream>::value;
+        }
+
+        /**
+         * @brief Builds `CREATE TABLE IF NOT EXISTS table (_id INTEGER PRIMARY KEY, column TYPE, ...);`.
+         */
+        template <typename Out>
+        static constexpr void create(Out &out)
+        {
+            out.append("CREATE TABLE IF NOT EXISTS ");
+            out.append(schema.table);
+            out.append(" (");
+            forEach([&](auto I)
+                    {
+                const auto &col = std::get<decltype(I)::value>(schema.columns);
+                using V = typename member_type<decltype(col.member)>::type;
+                out.append(I ? ", " : "");
+                out.append(col.name);
+                // Declared exactly as INTEGER PRIMARY KEY, _id aliases the rowid
+                out.append(I ? " " : " INTEGER PRIMARY KEY");
+                if (I)
+                    out.append(sqlType<V>()); });
+            out.append(");");
+        }
+
+        /**
+         * @brief Builds the upsert of a record, with one placeholder per column.
+         *
+         * The `DO UPDATE SET` clause updates the row in place, `BlobStream` columns bound to NULL
+         * keeping their stored content.
+         */
+        template <typename Out>
+        static constexpr void insert(Out &out)
+        {
+            out.append("INSERT INTO ");
+            out.append(schema.table);
+            out.append(" (");
+            forEach([&](auto I)
+                    {
+                out.append(I ? ", " : "");
+                out.append(std::get<decltype(I)::value>(schema.columns).name); });
+            out.append(") VALUES (");
+            forEach([&](auto I)
+                    { out.append(I ? ", ?" : "?"); });
+            out.append(") ON CONFLICT(_id) DO ");
+            if (columnCount == 1)
+                out.append("NOTHING");
+            forEach([&](auto I)
+                    {
+                if (!I)
+                    return;
+                std::string_view name = std::get<decltype(I)::value>(schema.columns).name;
+                out.append(I == 1 ? "UPDATE SET " : ", ");
+                out.append(name);
+                out.append(" = ");
+                if (isStream<decltype(I)::value>())
+                {
+                    out.append("coalesce(excluded.");
+                    out.append(name);
+                    out.append(", ");
+                    out.append(name);
+                    out.append(")");
+                }
+                else
+                {
+                    out.append("excluded.");
+                    out.append(name);
+                } });
+            out.append(";");
+        }
+
+        /**
+         * @brief Builds `SELECT column, ... FROM table`, without terminator.
+         *
+         * `BlobStream` columns are selected as `length(column)` so their content is not loaded.
+         */
+        template <typename Out>
+        static constexpr void select(Out &out)
+        {
+            out.append("SELECT ");
+            forEach([&](auto I)
+                    {
+                std::string_view name = std::get<decltype(I)::value>(schema.columns).name;
+                out.append(I ? ", " : "");
+                if (isStream<decltype(I)::value>())
+                {
+                    out.append("length(");
+                    out.append(name);
+                    out.append(") AS ");
+                }
+                out.append(name); });
+            out.append(" FROM ");
+            out.append(schema.table);
+        }
+
+        /**
+         * @brief Builds the selection of a record by `_id`, with one placeholder.
+         */
+        template <typename Out>
+        static constexpr void selectOne(Out &out)
+        {
+            select(out);
+            out.append(" WHERE _id = ? LIMIT 1;");
+        }
+
+        /**
+         * @brief Builds the deletion of a record by `_id`, with one placeholder.
+         */
+        template <typename Out>
+        static constexpr void remove(Out &out)
+        {
+            out.append("DELETE FROM ");
+            out.append(schema.table);
+            out.append(" WHERE _id = ?;");
+        }
+
+        /**
+         * @brief Calls `f` with `std::integral_constant<std::size_t, I>` for each column index I, in order.
+         *
+         * Unrolled at compile time, letting `f` use the index as a constant expression.
+         */
+        template <typename F>
+        static constexpr void forEach(F &&f)
+        {
+            forEach(f, std::make_index_sequence<columnCount>{});
+        }
+
+    private:
+        template <typename F, std::size_t... I>
+        static constexpr void forEach(F &&f, std::index_sequence<I...>)
+        {
+            (f(std::integral_constant<std::size_t, I>{}), ...);
+        }
+
+        /**
+         * @brief Returns the length of a statement.
+         */
+        static constexpr std::size_t measure(void (*build)(SqlLength &))
+        {
+            SqlLength length;
+            build(length);
+            return length.size;
+        }
+
+        /**
+         * @brief Returns the characters of a statement of length N.
+         */
+        template <std::size_t N>
+        static constexpr SqlText<N> fill(void (*build)(SqlText<N> &))
+        {
+            SqlText<N> text;
+            build(text);
+            return text;
+        }
+
+    public:
+        static constexpr std::size_t createLength = measure(&create<SqlLength>);
+        static constexpr SqlText<createLength> createSQL = fill<createLength>(&create<SqlText<createLength>>); ///< The `CREATE TABLE` statement.
+        static constexpr std::size_t insertLength = measure(&insert<SqlLength>);
+        static constexpr SqlText<insertLength> insertSQL = fill<insertLength>(&insert<SqlText<insertLength>>); ///< The upsert statement.
+        static constexpr std::size_t selectLength = measure(&select<SqlLength>);
+        static constexpr SqlText<selectLength> selectSQL = fill<selectLength>(&select<SqlText<selectLength>>); ///< The `SELECT` prefix.
+        static constexpr std::size_t selectOneLength = measure(&selectOne<SqlLength>);
+        static constexpr SqlText<selectOneLength> selectOneSQL = fill<selectOneLength>(&selectOne<SqlText<selectOneLength>>); ///< The `SELECT` by `_id` statement.
+        static constexpr std::size_t removeLength = measure(&remove<SqlLength>);
+        static constexpr SqlText<removeLength> removeSQL = fill<removeLength>(&remove<SqlText<removeLength>>); ///< The `DELETE` by `_id` statement.
+
+        /**
+         * @brief Returns a statement as a string, copied once from its compile-time text.
+         *
+         * @tparam Text The compile-time text of the statement, such as `insertSQL`.
+         */
+        template <const auto &Text>
+        static const std::string &query()
+        {
+            static const std::string query(Text.view());
+            return query;
+        }
+    };
+} // namespace sqlmate
@@ -1,2 +1,6 @@
 #include "../Database/DatabaseManager.hpp"
+#include "../Database/SQLite/MaintenanceScheduler.hpp"
+#include "../Database/QueryMetrics.hpp"
+#include "../Database/WorkloadCapture.hpp"
+#include "../Database/Transaction.hpp"
 #include "../Model/AModel.hpp"
\ No newline at end of file
@@ -0,0 +1,5 @@
+cd test && \
+mkdir -p build && cd build && \
+cmake .. && \
+cmake --build . && \
+ctest --output-on-failure | tee ../../test_output.txt
@@ -0,0 +1,605 @@
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sqlmate.hpp>
+
+using namespace sqlmate;
+
+/**
+ * Regression tests of the library.
+ *
+ * Each test runs on a fresh in-memory database and reports its failed checks; the program
+ * exits with a non-zero status if any check failed.
+ *
+ * Usage: tests
+ */
+
+class Session : public AModel
+{
+public:
+    TABLE_NAME("Sessions")
+    Session(std::shared_ptr<IDatabase> db) : AModel(db)
+    {
+        FIELDS(FIELD(user),
+               FIELD(expires))
+    }
+
+    std::string user;
+    int64_t expires = 0;
+};
+
+class Order;
+
+class Customer : public AModel
+{
+public:
+    TABLE_NAME("Customers")
+    Customer(std::shared_ptr<IDatabase> db) : AModel(db)
+    {
+        FIELDS(FIELD(name))
+        RELATIONS(HAS_MANY(orders, "customerId"))
+    }
+
+    std::string name;
+    std::vector<std::shared_ptr<Order>> orders;
+};
+
+class Order : public AModel
+{
+public:
+    TABLE_NAME("Orders")
+    Order(std::shared_ptr<IDatabase> db) : AModel(db)
+    {
+        FIELDS(FIELD(customerId),
+               FIELD(total))
+        RELATIONS(BELONGS_TO(customer, "customerId"))
+    }
+
+    int customerId = 0;
+    double total = 0;
+    std::shared_ptr<Customer> customer;
+};
+
+class Article : public AModel
+{
+public:
+    TABLE_NAME("Articles")
+    Article(std::shared_ptr<IDatabase> db) : AModel(db)
+    {
+        FIELDS(FIELD(title))
+        FULLTEXT("title");
+    }
+
+    std::string title;
+};
+
+class Note : public AModel
+{
+public:
+    TABLE_NAME("Notes")
+    Note(std::shared_ptr<IDatabase> db) : AModel(db)
+    {
+        FIELDS(FIELD(text),
+               FIELD(comment))
+    }
+
+    std::string text;
+    std::optional<std::string> comment;
+};
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &test, const std::string &what)
+{
+    if (condition)
+        return;
+    std::cerr << test << ": " << what << std::endl;
+    failures++;
+}
+
+static std::shared_ptr<IDatabase> freshDatabase(const std::string &name)
+{
+    // Named in-memory databases keep tests apart in the DatabaseManager registry
+    return DatabaseManager::getInstance().connect("file:" + name + "?mode=memory", SQLITE);
+}
+
+static std::shared_ptr<IDatabase> freshShardedDatabase(const std::string &name, std::size_t shards)
+{
+    // Sharded databases need file paths, the shards of a URI name would not be valid URIs
+    std::string path = (std::filesystem::temp_directory_path() / ("sqlmate_tests_" + name + ".db")).string();
+    for (std::size_t i = 0; i < shards; i++)
+        std::remove(ShardedDatabase::shardUrl(path, i).c_str());
+    return DatabaseManager::getInstance().connect(path, SQLITE, shards);
+}
+
+static void testRemoveWhereNotifiesSubscribers()
+{
+    const std::string test = "removeWhere notifies subscribers";
+    auto db = freshDatabase("remove_where");
+    for (int i = 0; i < 3; i++)
+    {
+        Session session(db);
+        session.user = "user" + std::to_string(i);
+        session.expires = i;
+        session.save();
+    }
+
+    std::vector<ChangeEvent> events;
+    int subscription = db->subscribe("Sessions", [&](const std::vector<ChangeEvent> &changes)
+                                     { events.insert(events.end(), changes.begin(), changes.end()); });
+    Session probe(db);
+    int64_t removed = probe.removeWhere<Session>("");
+    db->unsubscribe(subscription);
+
+    check(removed == 3, test, "expected 3 removed rows, got " + std::to_string(removed));
+    check(events.size() == 3, test, "expected 3 change events, got " + std::to_string(events.size()));
+    for (const auto &event : events)
+        check(event.op == ROW_DELETED, test, "expected deletions only");
+    check(probe.findAll<Session>().empty(), test, "expected an empty table");
+}
+
+static int64_t countRows(IDatabase &db, bool parameterized)
+{
+    int64_t count = -1;
+    RowCallBackWrapper cb([&](IRow &row)
+                          {
+        count = row.getInt64(0);
+        return (0); });
+    if (parameterized)
+        db.exec("SELECT count(*) FROM t WHERE ? = 1;", {FieldInfo::of(1)}, &cb);
+    else
+    {
+        QueryCallBackWrapper raw([&](int, char **argv, char **)
+                                 {
+            count = std::stoll(argv[0]);
+            return (0); });
+        db.exec("SELECT count(*) FROM t;", &raw);
+    }
+    return (count);
+}
+
+static void testReconnectDropsCachedStatements()
+{
+    const std::string test = "reconnect drops cached statements";
+    SQLite db;
+    db.connect(":memory:");
+    db.exec("CREATE TABLE t (v INTEGER);", nullptr);
+    db.exec("INSERT INTO t VALUES (?);", {FieldInfo::of(1)}, nullptr);
+    check(countRows(db, true) == 1, test, "expected 1 row before reconnecting");
+
+    db.connect(":memory:");
+    db.exec("CREATE TABLE t (v INTEGER);", nullptr);
+    db.exec("INSERT INTO t VALUES (?);", {FieldInfo::of(1)}, nullptr);
+    db.exec("INSERT INTO t VALUES (?);", {FieldInfo::of(2)}, nullptr);
+    check(countRows(db, true) == 2, test, "parameterized queries must use the new handle");
+    check(countRows(db, false) == 2, test, "raw queries must see the parameterized inserts");
+    db.disconnect();
+}
+
+static void testStatementCacheIsBounded()
+{
+    const std::string test = "statement cache is bounded";
+    auto db = freshDatabase("statement_cache");
+    Session probe(db);
+    probe.save();
+    for (int i = 0; i < 1000; i++)
+        probe.findWhere<Session>("expires = " + std::to_string(i));
+    int64_t cached = db->memoryStats().cachedStatements;
+    check(cached > 0 && cached <= 256, test, "expected at most 256 cached statements, got " + std::to_string(cached));
+}
+
+static void testRelationsLoadInChunks()
+{
+    const std::string test = "relations load in chunks";
+    auto db = freshDatabase("relations");
+    Transaction transaction(db);
+    for (int i = 0; i < 1200; i++)
+    {
+        Customer customer(db);
+        customer.name = "customer" + std::to_string(i);
+        customer.save();
+        Order order(db);
+        order.customerId = customer.getId();
+        order.total = i;
+        order.save();
+    }
+    transaction.commit();
+
+    Customer probe(db);
+    std::size_t loaded = 0;
+    for (auto &customer : probe.findAll<Customer>({"orders"}))
+        loaded += customer->orders.size();
+    check(loaded == 1200, test, "expected 1200 children, got " + std::to_string(loaded));
+
+    Order orderProbe(db);
+    std::size_t parents = 0;
+    for (auto &order : orderProbe.findAll<Order>({"customer"}))
+        parents += order->customer && order->customer->getId() == order->customerId;
+    check(parents == 1200, test, "expected 1200 parents, got " + std::to_string(parents));
+}
+
+static void testFailedStatementKeepsEarlierChanges()
+{
+    const std::string test = "failed statement keeps earlier changes";
+    auto db = freshDatabase("failed_statement");
+    db->exec("CREATE TABLE t (_id INTEGER PRIMARY KEY, k TEXT UNIQUE);", nullptr);
+    db->exec("INSERT INTO t VALUES (1, 'a'), (2, 'b'), (3, 'c');", nullptr);
+
+    std::vector<ChangeEvent> events;
+    int subscription = db->subscribe("t", [&](const std::vector<ChangeEvent> &changes)
+                                     { events.insert(events.end(), changes.begin(), changes.end()); });
+    db->exec("BEGIN;", nullptr);
+    // The second statement updates row 1 before failing on row 2
+    Result<void> result = db->tryExec("UPDATE t SET k = 'd' WHERE _id = 3; "
+                                      "UPDATE t SET k = CASE _id WHEN 1 THEN 'z' WHEN 2 THEN 'd' ELSE k END;",
+                                      nullptr);
+    db->exec("COMMIT;", nullptr);
+    db->unsubscribe(subscription);
+
+    check(!result.ok(), test, "expected the second statement to fail");
+    check(events.size() == 1, test, "expected 1 change event, got " + std::to_string(events.size()));
+    check(!events.empty() && events[0].rowid == 3, test, "expected the change of row 3");
+}
+
+static void testShardedCommitIsNotRetried()
+{
+    const std::string test = "sharded commit is not retried";
+    auto db = freshShardedDatabase("commit", 2);
+    std::string path = (std::filesystem::temp_directory_path() / "sqlmate_tests_commit.db").string();
+    BusyPolicy policy;
+    policy.timeout = std::chrono::milliseconds(50);
+    db->setBusyPolicy(policy);
+    db->exec("CREATE TABLE t (v INTEGER);", nullptr);
+
+    // A reader of the second shard keeps its commit busy once the first shard has committed
+    SQLite reader;
+    reader.connect(ShardedDatabase::shardUrl(path, 1));
+    reader.exec("BEGIN DEFERRED; SELECT count(*) FROM t;", nullptr);
+    int runs = 0;
+    bool busy = false;
+    try
+    {
+        Transaction::run(db, [&]()
+                         {
+            runs++;
+            db->exec("INSERT INTO t VALUES (1);", nullptr); });
+    }
+    catch (const BusyError &)
+    {
+        busy = true;
+    }
+    reader.exec("ROLLBACK;", nullptr);
+    reader.disconnect();
+    DatabaseManager::getInstance().disconnect(path);
+
+    check(busy, test, "expected the busy commit to be reported");
+    check(runs == 1, test, "expected a single run, got " + std::to_string(runs));
+}
+
+static void testShardedSearchIsMerged()
+{
+    const std::string test = "sharded search is merged";
+    auto db = freshShardedDatabase("search", 4);
+    for (int i = 0; i < 40; i++)
+    {
+        Article article(db);
+        article.title = (i % 4 == 0 ? "sqlite orm " : "other words ") + std::to_string(i);
+        article.save();
+    }
+
+    Article probe(db);
+    auto found = probe.search<Article>("sqlite", 3);
+    check(found.size() == 3, test, "expected 3 matches, got " + std::to_string(found.size()));
+    for (const auto &article : found)
+        check(article->title.find("sqlite") == 0, test, "unexpected match " + article->title);
+
+    bool rejected = false;
+    try
+    {
+        probe.findWhere<Article>("title LIKE 'sqlite%' ORDER BY title");
+    }
+    catch (const ModelError &)
+    {
+        rejected = true;
+    }
+    check(rejected, test, "expected ORDER BY to be rejected");
+    check(probe.findWhere<Article>("title = 'LIMIT'").empty(), test, "expected quoted keywords to be accepted");
+    check(probe.findWhere<Article>("title LIKE 'sqlite%'").size() == 10, test, "expected 10 records across shards");
+}
+
+static void testQueryMetricsAreBounded()
+{
+    const std::string test = "query metrics are bounded";
+    auto db = freshDatabase("query_metrics");
+    db->exec("CREATE TABLE t (v INTEGER);", nullptr);
+    auto metrics = std::make_shared<QueryMetrics>(std::chrono::milliseconds(100), 128, 10);
+    db->setObserver(metrics);
+    for (int i = 0; i < 100; i++)
+        db->exec("SELECT count(*) FROM t WHERE v = " + std::to_string(i) + ";", nullptr);
+    db->setObserver(nullptr);
+
+    QueryMetrics::Snapshot snapshot = metrics->snapshot();
+    uint64_t calls = 0;
+    for (const auto &[sql, stats] : snapshot.perStatement)
+        calls += stats.calls;
+    check(snapshot.perStatement.size() == 11, test, "expected 10 statements and the overflow, got " + std::to_string(snapshot.perStatement.size()));
+    check(snapshot.perStatement.count(QueryMetrics::otherStatements) && snapshot.perStatement.at(QueryMetrics::otherStatements).calls == 90,
+          test, "expected 90 runs in the overflow");
+    check(calls == snapshot.statements, test, "expected every run to be counted once");
+}
+
+static void testBusyEvolutionIsReported()
+{
+    const std::string test = "busy evolution is reported";
+    std::string path = (std::filesystem::temp_directory_path() / "sqlmate_tests_evolution.db").string();
+    std::remove(path.c_str());
+    auto db = DatabaseManager::getInstance().connect(path, SQLITE);
+    BusyPolicy policy;
+    policy.timeout = std::chrono::milliseconds(50);
+    db->setBusyPolicy(policy);
+    db->exec("CREATE TABLE Sessions (_id INTEGER PRIMARY KEY AUTOINCREMENT, user TEXT);", nullptr);
+
+    // Adding the missing expires column needs the write lock held by the writer
+    SQLite writer;
+    writer.connect(path);
+    writer.exec("BEGIN IMMEDIATE;", nullptr);
+    Session session(db);
+    Result<void> result = session.trySave();
+    writer.exec("ROLLBACK;", nullptr);
+    writer.disconnect();
+
+    check(!result.ok(), test, "expected the save to fail");
+    check(result.error().kind() == ERROR_BUSY, test, "expected a busy failure, got " + result.error().message());
+    check(session.trySave().ok(), test, "expected the save to succeed once the lock is released");
+    DatabaseManager::getInstance().disconnect(path);
+}
+
+static void testImportRejectsOutOfRangeIntegers()
+{
+    const std::string test = "import rejects out of range integers";
+    auto db = freshDatabase("import_range");
+    Order probe(db);
+    std::istringstream in("customerId,total\n4294967297,1.5\n");
+    bool rejected = false;
+    try
+    {
+        probe.importStream<Order>(in, CSV);
+    }
+    catch (const ModelError &)
+    {
+        rejected = true;
+    }
+    check(rejected, test, "expected a customerId past INT_MAX to be rejected");
+    check(probe.findAll<Order>().empty(), test, "expected no imported record");
+}
+
+static void testExportPutsIdFirst()
+{
+    const std::string test = "export puts _id first";
+    auto db = freshDatabase("export_order");
+    Order order(db);
+    order.customerId = 7;
+    order.total = 2.5;
+    order.save();
+
+    std::ostringstream out;
+    int64_t exported = order.exportStream<Order>(out, CSV);
+    check(exported == 1, test, "expected 1 exported record, got " + std::to_string(exported));
+    check(out.str().rfind("_id,customerId,total\n", 0) == 0, test, "unexpected header in " + out.str());
+}
+
+static void testCsvFieldsAcrossChunks()
+{
+    const std::string test = "CSV fields across chunks";
+    // Quoted fields of 300 KiB with escaped quotes and line breaks, the fourth one straddling the first chunk boundary
+    std::vector<std::string> texts;
+    std::string csv = "text,comment\n";
+    for (int i = 0; i < 6; i++)
+    {
+        std::string text(300 * 1024 + i, 'a' + i);
+        for (std::size_t at = 1000; at < text.size(); at += 4096)
+            text[at] = (at % 3 ? '"' : '\n');
+        texts.push_back(text);
+        std::string quoted;
+        for (char c : text)
+            quoted += (c == '"' ? "\"\"" : std::string(1, c));
+        csv += "\"" + quoted + "\",\"x,y\"\n";
+    }
+
+    std::istringstream in(csv);
+    RecordReader reader(in, CSV);
+    std::size_t records = 0;
+    while (reader.next())
+    {
+        check(reader.size() == 2, test, "expected 2 fields in record " + std::to_string(records));
+        if (records < texts.size() && reader.size() == 2)
+        {
+            check(reader.value(0) == texts[records], test, "text of record " + std::to_string(records) + " differs");
+            check(reader.value(1) == "x,y", test, "comment of record " + std::to_string(records) + " differs");
+        }
+        records++;
+    }
+    check(records == texts.size(), test, "expected 6 records, got " + std::to_string(records));
+}
+
+static void testNullAndEmptyRoundTrip()
+{
+    const std::string test = "NULL and empty round trip";
+    for (DataFormat format : {CSV, NDJSON})
+    {
+        std::string name = (format == CSV ? "csv" : "ndjson");
+        auto source = freshDatabase("round_trip_" + name);
+        const std::vector<std::optional<std::string>> comments = {std::nullopt, "", "a \"quoted\", text\non two lines", "\xF0\x9F\x98\x80"};
+        for (const auto &comment : comments)
+        {
+            Note note(source);
+            note.text = comment.value_or("");
+            note.comment = comment;
+            note.save();
+        }
+
+        std::stringstream stream;
+        Note probe(source);
+        probe.exportStream<Note>(stream, format);
+        auto target = freshDatabase("round_trip_" + name + "_target");
+        Note targetProbe(target);
+        int64_t imported = targetProbe.importStream<Note>(stream, format);
+        check(imported == 4, test, name + ": expected 4 imported records, got " + std::to_string(imported));
+
+        std::map<int, std::shared_ptr<Note>> byId;
+        for (auto &note : targetProbe.findAll<Note>())
+            byId[note->getId()] = note;
+        for (auto &original : probe.findAll<Note>())
+        {
+            auto copy = byId.find(original->getId());
+            check(copy != byId.end(), test, name + ": record " + std::to_string(original->getId()) + " is missing");
+            if (copy == byId.end())
+                continue;
+            check(copy->second->comment == original->comment, test, name + ": comment of record " + std::to_string(original->getId()) + " differs");
+            check(copy->second->text == original->text, test, name + ": text of record " + std::to_string(original->getId()) + " differs");
+        }
+    }
+}
+
+static void testJsonSurrogatePairs()
+{
+    const std::string test = "JSON surrogate pairs";
+    std::istringstream in("{\"text\":\"\\ud83d\\ude00 \\u00e9\",\"comment\":null}\n"
+                          "{\"text\":\"\\ud83d\",\"comment\":\"\"}\n");
+    RecordReader reader(in, NDJSON);
+    check(reader.next(), test, "expected a first record");
+    check(reader.value(0) == "\xF0\x9F\x98\x80 \xC3\xA9", test, "expected the pair to join into one code point");
+    check(reader.isNull(1), test, "expected null to read as NULL");
+    check(reader.next(), test, "expected a second record");
+    check(reader.value(0) == "\xED\xA0\xBD", test, "expected a lone surrogate to be kept as is");
+    check(!reader.isNull(1) && reader.value(1).empty(), test, "expected an empty text, not NULL");
+    check(!reader.next(), test, "expected two records");
+}
+
+static void testShardRoutingAndFanOut()
+{
+    const std::string test = "shard routing and fan-out";
+    auto db = freshShardedDatabase("routing", 3);
+    std::vector<int> ids;
+    for (int i = 0; i < 30; i++)
+    {
+        Session session(db);
+        session.user = "user" + std::to_string(i);
+        session.expires = i;
+        session.save();
+        ids.push_back(session.getId());
+    }
+
+    // Each record lives on the shard its _id hashes to, and only there
+    int64_t routed = 0;
+    for (int id : ids)
+    {
+        int64_t count = 0;
+        RowCallBackWrapper cb([&](IRow &row)
+                              {
+            count = row.getInt64(0);
+            return (0); });
+        db->shard(static_cast<uint64_t>(id)).exec("SELECT count(*) FROM Sessions WHERE _id = ?;", {FieldInfo::of(id)}, &cb);
+        routed += count;
+    }
+    check(routed == 30, test, "expected every record on its own shard, found " + std::to_string(routed));
+
+    Session probe(db);
+    check(probe.findAll<Session>().size() == 30, test, "expected findAll to merge the 30 records");
+    check(probe.findWhere<Session>("expires < 10").size() == 10, test, "expected findWhere to merge 10 records");
+    auto found = probe.findOne<Session>(ids[7]);
+    check(found && found->user == "user7", test, "expected findOne to read the routed shard");
+    check(probe.updateWhere<Session>("expires >= 20", {{"user", FieldInfo::of(std::string("late"))}}) == 10, test,
+          "expected updateWhere to count the changes of every shard");
+    check(probe.removeWhere<Session>("") == 30, test, "expected removeWhere to count the rows of every shard");
+}
+
+static void testRebuildWithConcurrentWriter()
+{
+    const std::string test = "rebuild with a concurrent writer";
+    std::string path = (std::filesystem::temp_directory_path() / "sqlmate_tests_rebuild.db").string();
+    std::remove(path.c_str());
+    auto db = DatabaseManager::getInstance().connect(path, SQLITE);
+    // expires was declared as TEXT, the model wants an INTEGER: only a rebuild changes a column type
+    db->exec("CREATE TABLE Sessions (_id INTEGER PRIMARY KEY, user TEXT, expires TEXT);", nullptr);
+    db->exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 1000) "
+             "INSERT INTO Sessions SELECT i, 'user' || i, i FROM n;",
+             nullptr);
+
+    SQLite writer;
+    writer.connect(path);
+    int batches = 0;
+    SchemaOptions options;
+    options.batchSize = 100;
+    options.progress = [&](const SchemaProgress &)
+    {
+        // Between batches: a new row, an update of a copied row, and a delete of a row not copied yet
+        batches++;
+        writer.exec("INSERT INTO Sessions (_id, user, expires) VALUES (" + std::to_string(2000 + batches) + ", 'new', 0);", nullptr);
+        writer.exec("UPDATE Sessions SET user = 'updated' WHERE _id = " + std::to_string(batches) + ";", nullptr);
+        writer.exec("DELETE FROM Sessions WHERE _id = " + std::to_string(1000 - batches) + ";", nullptr);
+    };
+    std::unordered_map<std::string, FieldInfo> columns = {{"_id", FieldInfo::of(0)},
+                                                          {"user", FieldInfo::of(std::string())},
+                                                          {"expires", FieldInfo::of(int64_t(0))}};
+    SchemaChanges changes = db->evolveTable("Sessions", columns, options);
+    writer.disconnect();
+
+    int64_t rows = -1;
+    int64_t updated = -1;
+    std::string type;
+    RowCallBackWrapper count([&](IRow &row)
+                             {
+        rows = row.getInt64(0);
+        updated = row.getInt64(1);
+        return (0); });
+    db->exec("SELECT count(*), sum(user = 'updated') FROM Sessions;", {}, &count);
+    RowCallBackWrapper declared([&](IRow &row)
+                                {
+        type = std::string(row.getText(0));
+        return (0); });
+    db->exec("SELECT type FROM pragma_table_info('Sessions') WHERE name = 'expires';", {}, &declared);
+    DatabaseManager::getInstance().disconnect(path);
+
+    check(changes.rebuilt, test, "expected the table to be rebuilt");
+    check(batches >= 10, test, "expected at least 10 batches, got " + std::to_string(batches));
+    check(rows == 1000, test, "expected 1000 rows, the writes and deletes of the writer included, got " + std::to_string(rows));
+    check(updated == batches, test, "expected " + std::to_string(batches) + " updated rows, got " + std::to_string(updated));
+    check(type == "INTEGER", test, "expected expires to be an INTEGER, got " + type);
+}
+
+int main()
+{
+    std::vector<std::function<void()>> tests = {
+        testRemoveWhereNotifiesSubscribers,
+        testReconnectDropsCachedStatements,
+        testStatementCacheIsBounded,
+        testRelationsLoadInChunks,
+        testFailedStatementKeepsEarlierChanges,
+        testShardedCommitIsNotRetried,
+        testShardedSearchIsMerged,
+        testQueryMetricsAreBounded,
+        testBusyEvolutionIsReported,
+        testImportRejectsOutOfRangeIntegers,
+        testExportPutsIdFirst,
+        testCsvFieldsAcrossChunks,
+        testNullAndEmptyRoundTrip,
+        testJsonSurrogatePairs,
+        testShardRoutingAndFanOut,
+        testRebuildWithConcurrentWriter,
+    };
+
+    for (const auto &test : tests)
+        test();
+    if (failures)
+        std::cerr << failures << " failed checks" << std::endl;
+    else
+        std::cout << tests.size() << " tests passed" << std::endl;
+    return (failures ? 1 : 0);
+}